@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+
+# Accelerator and bus throughput over the UART-to-Wishbone bridge, no CPU involved
+#
+#   python3 local_litex_sim.py --with-uartbone --csr-csv csr.csv [--accel-degree N] ...
+#   litex_server --uart --uart-port socket://localhost:2430
+#   python3 accel_bridge_bench.py --csr-csv csr.csv
+#
+# Single and batch operations are driven through litex_server (RemoteClient).
+# The accelerator's cycles register times each operation in sys_clk cycles,
+# the host clock shows what the bridge and the bus sustain around it. Every
+# result is checked against the bit-exact model (fixed_codegen.horner).
+
+import argparse
+import random
+import time
+
+from litex import RemoteClient
+
+from fixed_codegen import horner
+
+CTRL_START  = 1 << 0
+CTRL_RESET  = 1 << 1
+CTRL_MODE   = 1 << 2
+STATUS_DONE = 1 << 1
+
+
+class BridgeAccel:
+    """InferenceAccelerator registers and sample memory seen from the host."""
+
+    def __init__(self, wb):
+        self.wb = wb
+        self.regs = wb.regs
+        self.data_width  = wb.constants.inference_accel_data_width
+        self.frac_bits   = wb.constants.inference_accel_frac_bits
+        self.batch_depth = wb.constants.inference_accel_batch_depth
+        self.max_degree  = wb.constants.inference_accel_max_degree
+        self.clk_freq    = wb.constants.config_clock_frequency
+        self.mem_base    = wb.mems.inference_accel_mem.base
+
+    def sign_extend(self, v):
+        v &= (1 << self.data_width) - 1
+        return v - (1 << self.data_width) if v >> (self.data_width - 1) else v
+
+    def reset(self):
+        self.regs.inference_accel_control.write(CTRL_RESET)
+        self.regs.inference_accel_control.write(0)
+
+    def set_poly(self, coeffs_q):
+        """Coefficients c0 .. cN (ascending powers), degree N."""
+        mask = (1 << self.data_width) - 1
+        self.regs.inference_accel_bias.write(coeffs_q[0] & mask)
+        self.regs.inference_accel_weight.write(coeffs_q[1] & mask)
+        for k in range(2, len(coeffs_q)):
+            getattr(self.regs, "inference_accel_coeff{}".format(k)).write(coeffs_q[k] & mask)
+        self.regs.inference_accel_degree.write(len(coeffs_q) - 1)
+
+    def compute(self, x_q):
+        """Single operation: (result, cycles)."""
+        self.regs.inference_accel_input_data.write(x_q & ((1 << self.data_width) - 1))
+        self.regs.inference_accel_control.write(CTRL_START)
+        self.regs.inference_accel_control.write(0)
+        while not self.regs.inference_accel_status.read() & STATUS_DONE:
+            pass
+        return self.sign_extend(self.regs.inference_accel_result.read()), self.regs.inference_accel_cycles.read()
+
+    def batch(self, xs_q, bank=0):
+        """Batch operation on one bank: (results, cycles, write/run/read seconds)."""
+        base = bank * self.batch_depth
+        mask = (1 << self.data_width) - 1
+        t0 = time.perf_counter()
+        self.wb.write(self.mem_base + 4 * base, [x & mask for x in xs_q])
+        t1 = time.perf_counter()
+        self.regs.inference_accel_ev_pending.write(1)
+        self.regs.inference_accel_batch_base.write(base)
+        self.regs.inference_accel_batch_count.write(len(xs_q))
+        self.regs.inference_accel_control.write(CTRL_MODE)
+        self.regs.inference_accel_control.write(CTRL_MODE | CTRL_START)
+        self.regs.inference_accel_control.write(CTRL_MODE)
+        while not self.regs.inference_accel_ev_pending.read() & 1:
+            pass
+        t2 = time.perf_counter()
+        results = self.wb.read(self.mem_base + 4 * (2 * self.batch_depth + base), len(xs_q))
+        t3 = time.perf_counter()
+        cycles = self.regs.inference_accel_cycles.read()
+        return [self.sign_extend(v) for v in results], cycles, (t1 - t0, t2 - t1, t3 - t2)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Accelerator throughput over the UARTBone bridge (local_litex_sim.py --with-uartbone).")
+    parser.add_argument("--host",    default="localhost", help="litex_server host.")
+    parser.add_argument("--port",    default=1234, type=int, help="litex_server port.")
+    parser.add_argument("--csr-csv", default="csr.csv", help="CSR map written by the sim build (--csr-csv).")
+    parser.add_argument("--samples", default=1024, type=int, help="Samples per measurement.")
+    parser.add_argument("--degree",  default=None, type=int, help="Polynomial degree (default: accelerator maximum).")
+    parser.add_argument("--seed",    default=0, type=int, help="Random inputs and coefficients seed.")
+    args = parser.parse_args()
+
+    wb = RemoteClient(host=args.host, port=args.port, csr_csv=args.csr_csv)
+    wb.open()
+    try:
+        accel = BridgeAccel(wb)
+        degree = args.degree or accel.max_degree
+        if not 1 <= degree <= accel.max_degree:
+            parser.error("degree {} outside 1 .. {}".format(degree, accel.max_degree))
+        rng = random.Random(args.seed)
+        one = 1 << accel.frac_bits
+        coeffs = [rng.randint(-one, one) for _ in range(degree + 1)]
+        xs = [rng.randint(-one, one) for _ in range(args.samples)]
+        expected = [horner(coeffs, x, accel.frac_bits, accel.data_width) for x in xs]
+
+        print("Accelerator: Q{}.{}, degree {} of {}, batch depth {}, sys_clk {} Hz".format(
+            accel.data_width - accel.frac_bits, accel.frac_bits, degree, accel.max_degree,
+            accel.batch_depth, accel.clk_freq))
+        accel.reset()
+        accel.set_poly(coeffs)
+
+        # Single operations: CSR round trips dominate
+        n_single = min(args.samples, 256)
+        errors, cycles = 0, 0
+        t = time.perf_counter()
+        for x, y in zip(xs[:n_single], expected):
+            r, c = accel.compute(x)
+            errors += r != y
+            cycles += c
+        elapsed = time.perf_counter() - t
+        print("Single: {} samples, {:.0f} samples/s over the bridge, {:.1f} accelerator cycles/sample, {} mismatches".format(
+            n_single, n_single / elapsed, cycles / n_single, errors))
+
+        # Batches: memory bursts, one sample per cycle in the accelerator
+        errors, cycles, times = 0, 0, [0.0, 0.0, 0.0]
+        t = time.perf_counter()
+        for i in range(0, len(xs), accel.batch_depth):
+            results, c, dt = accel.batch(xs[i:i + accel.batch_depth], bank=(i // accel.batch_depth) & 1)
+            errors += sum(r != y for r, y in zip(results, expected[i:]))
+            cycles += c
+            times = [a + b for a, b in zip(times, dt)]
+        elapsed = time.perf_counter() - t
+        print("Batch:  {} samples, {:.0f} samples/s over the bridge (write {:.0%}, run {:.0%}, read {:.0%}), {} mismatches".format(
+            len(xs), len(xs) / elapsed, *[x / elapsed for x in times], errors))
+        print("Accelerator alone: {} cycles, {:.3f} cycles/sample, {:.0f} samples/s at sys_clk".format(
+            cycles, cycles / len(xs), len(xs) * accel.clk_freq / cycles))
+    finally:
+        wb.close()
+
+
+if __name__ == "__main__":
+    main()
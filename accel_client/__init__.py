@@ -0,0 +1,12 @@
+# Host client for the firmware's binary inference protocol (uart_proto.h)
+#
+#   from accel_client import AccelClient
+#   with AccelClient("/dev/ttyUSB1") as accel:
+#       y = accel.predict(X[:, 2])
+#
+# python -m accel_client --help for the command line (info, bench, check).
+
+from .client import AccelClient
+from .protocol import ProtocolError
+
+__all__ = ["AccelClient", "ProtocolError"]
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+
+# Command line: python -m accel_client --port /dev/ttyUSB1 {info,bench,check,load-model}
+#   bench --encoding delta --frac-bits 4: compact results, see uart_proto.h
+
+import argparse
+import sys
+
+from .check import check_model
+from .client import AccelClient
+
+
+def diabetes_model(degree):
+    from sklearn.datasets import load_diabetes
+    from sklearn.linear_model import LinearRegression
+    from sklearn.pipeline import make_pipeline
+    from sklearn.preprocessing import PolynomialFeatures
+    X, y = load_diabetes(return_X_y=True)
+    X = X[:, [2]] # Same single feature as lgr_microlgen.py
+    if degree == 1:
+        model = LinearRegression()
+    else:
+        model = make_pipeline(PolynomialFeatures(degree), LinearRegression())
+    return model.fit(X[:-20], y[:-20]), X
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Batch inference against the board or the simulation.")
+    parser.add_argument("--port",     required=True,             help="Serial port, sim pty or pyserial URL.")
+    parser.add_argument("--baudrate", default=115200, type=int,  help="UART baudrate.")
+    parser.add_argument("--window",   default=2,      type=int,  help="Frames in flight.")
+    parser.add_argument("--no-enter", action="store_true",       help="Firmware already in binary mode (BOOT_BINARY build).")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    sub.add_parser("info", help="Show the firmware protocol parameters.")
+    bench = sub.add_parser("bench", help="Throughput and latency benchmark.")
+    bench.add_argument("--samples", default=4096, type=int, help="Samples for the throughput run.")
+    bench.add_argument("--rounds",  default=100,  type=int, help="Frames for the latency run.")
+    bench.add_argument("--encoding", default="fixed", choices=["fixed", "delta"], help="Result encoding.")
+    bench.add_argument("--frac-bits", default=None, type=int, help="Result fraction bits (default: all).")
+    check = sub.add_parser("check", help="Bit-exactness check of a diabetes model against sklearn.")
+    check.add_argument("--degree", default=1, type=int, help="Polynomial degree (1: LinearRegression).")
+    load = sub.add_parser("load-model", help="Upload an accelerator blob (fixed_codegen.py).")
+    load.add_argument("blob", help="Blob file.")
+    args = parser.parse_args()
+
+    with AccelClient(args.port, baudrate=args.baudrate, window=args.window, enter=not args.no_enter) as accel:
+        if args.cmd == "info":
+            for k, v in accel.info.items():
+                print("{:<12} {}".format(k, v))
+            print("{:<12} {}".format("frame", accel.frame_samples))
+        elif args.cmd == "bench":
+            accel.set_encoding(args.encoding, args.frac_bits)
+            t = accel.measure_throughput(args.samples)
+            print("Throughput: {:.0f} samples/s ({} samples in {:.3f} s), link utilization {:.0%}".format(
+                t["samples_per_s"], t["samples"], t["seconds"], t["link_utilization"]))
+            print("Replies: {:.2f} bytes/sample ({} encoding, {} fraction bits)".format(
+                t["reply_bytes_per_sample"], args.encoding, accel.frac_bits - accel.drop_bits))
+            for n in (1, accel.frame_samples):
+                l = accel.measure_latency(args.rounds, n)
+                print("Latency ({:>3} samples/frame): mean {:.2f} ms, p50 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms".format(
+                    n, l["mean"] * 1e3, l["p50"] * 1e3, l["p99"] * 1e3, l["max"] * 1e3))
+        elif args.cmd == "check":
+            model, X = diabetes_model(args.degree)
+            r = check_model(accel, model, X)
+            print("{} samples, {} mismatches against the integer model".format(r["samples"], r["mismatches"]))
+            if r["first_mismatch"]:
+                print("First mismatch: index {}, x {}, accelerator {}, expected {}".format(*r["first_mismatch"]))
+            print("Against sklearn: max |error| {:.6f}, RMSE {:.6f}".format(r["max_abs_error"], r["rmse"]))
+            return 1 if r["mismatches"] else 0
+        elif args.cmd == "load-model":
+            with open(args.blob, "rb") as f:
+                accel.load_model(f.read())
+            print("Model loaded")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,34 @@
+# Bit-exactness check of the accelerator against the fixed-point reference
+
+import numpy as np
+
+from fixed_codegen import (ACCEL_KIND_LINEAR, ACCEL_KIND_POLY, accel_blob, horner, model_accel_coeffs,
+    polynomial_params, quantize)
+
+
+def accel_coeffs(model, frac_bits):
+    """Quantized Horner coefficients and blob kind of a LinearRegression or a
+    PolynomialFeatures + LinearRegression pipeline."""
+    if hasattr(model, "steps"):
+        return quantize(polynomial_params(model), frac_bits), ACCEL_KIND_POLY
+    return model_accel_coeffs(model, frac_bits), ACCEL_KIND_LINEAR
+
+
+def check_model(client, model, X, upload=True):
+    """Upload `model`, run X (one feature) through the accelerator and compare
+    with the bit-exact integer model and with sklearn's float predictions."""
+    frac_bits, data_width = client.frac_bits, client.info["data_width"]
+    coeffs, kind = accel_coeffs(model, frac_bits)
+    if upload:
+        client.load_model(accel_blob(coeffs, frac_bits, kind))
+
+    X = np.asarray(X, dtype=np.float64).reshape(-1, 1)
+    xq = quantize(X[:, 0], frac_bits)
+    got = client.predict_fixed(xq)
+    expected = np.array([horner(coeffs, x, frac_bits, data_width) for x in xq], dtype=np.int64)
+    mismatches = np.flatnonzero(got != expected)
+    float_err = got / float(1 << frac_bits) - model.predict(X)
+    return dict(samples=len(xq), mismatches=len(mismatches),
+        first_mismatch=None if not len(mismatches) else
+            (int(mismatches[0]), int(xq[mismatches[0]]), int(got[mismatches[0]]), int(expected[mismatches[0]])),
+        max_abs_error=float(np.abs(float_err).max()), rmse=float(np.sqrt((float_err ** 2).mean())))
@@ -0,0 +1,167 @@
+# Batch inference client for the firmware's binary protocol
+
+import collections
+import struct
+import time
+
+import numpy as np
+
+from . import protocol
+
+# Firmware receive ring (uart_ring.h UART_RING_RX_SIZE): frames in flight must fit
+FIRMWARE_RX_RING = 2048
+CONSOLE_BANNER   = b"send an EXIT frame to leave"
+
+
+class AccelClient:
+    """Talks to the firmware over a serial port, the sim's pty or any pyserial
+    URL (e.g. socket://localhost:1234 for a serial2tcp sim)."""
+
+    def __init__(self, port, baudrate=115200, timeout=5.0, window=2, enter=True):
+        import serial
+        self.port = serial.serial_for_url(port, baudrate=baudrate, timeout=timeout)
+        self.window = max(1, window)
+        self.seq = 0
+        self.rx_bytes = 0
+        self.encoding, self.drop_bits, self.result_bytes = protocol.ENC_FIXED, 0, None
+        if enter:
+            self.enter_binary()
+        self.info = self.get_info()
+        # Split batches so that `window` frames fit in the firmware receive ring
+        per_frame = (FIRMWARE_RX_RING // self.window - protocol.HEADER_LEN - protocol.CRC_LEN) // self.sample_bytes
+        self.frame_samples = max(1, min(self.info["max_samples"], per_frame))
+
+    # Session ----------------------------------------------------------------------------------------
+
+    def enter_binary(self):
+        """Type the `binary` console command and wait for the mode banner."""
+        self.port.reset_input_buffer()
+        self.port.write(b"\nbinary\n")
+        data = b""
+        while CONSOLE_BANNER not in data:
+            c = self.port.read(1)
+            if not c:
+                raise protocol.ProtocolError("no binary mode banner from the firmware console")
+            data += c
+        self.port.readline()
+
+    def close(self):
+        try:
+            self._request(protocol.EXIT)
+        finally:
+            self.port.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def _next_seq(self):
+        seq = self.seq
+        self.seq = (self.seq + 1) & 0xff
+        return seq
+
+    def _send(self, type, payload=b""):
+        seq = self._next_seq()
+        self.port.write(protocol.encode(type, seq, payload))
+        return seq
+
+    def _receive(self, seq):
+        type, rseq, payload = protocol.read_frame(self.port)
+        self.rx_bytes += protocol.HEADER_LEN + len(payload) + protocol.CRC_LEN
+        if rseq != seq:
+            raise protocol.ProtocolError("reply seq {} while waiting for {}".format(rseq, seq))
+        return payload
+
+    def _request(self, type, payload=b""):
+        return self._receive(self._send(type, payload))
+
+    def get_info(self):
+        version, sample_bytes, frac_bits, max_degree, max_samples, data_width = struct.unpack(
+            "<BBBBHB", self._request(protocol.INFO))
+        if version != protocol.VERSION:
+            raise protocol.ProtocolError("firmware protocol version {}".format(version))
+        return dict(version=version, sample_bytes=sample_bytes, frac_bits=frac_bits,
+            max_degree=max_degree, max_samples=max_samples, data_width=data_width)
+
+    def set_encoding(self, encoding="fixed", frac_bits=None):
+        """Result encoding for the rest of the session: "fixed" or "delta",
+        truncated to frac_bits fraction bits (default: full precision)."""
+        encoding = protocol.ENCODINGS.get(encoding, encoding)
+        frac_bits = self.frac_bits if frac_bits is None else frac_bits
+        self.encoding, frac_bits, self.result_bytes = struct.unpack(
+            "<BBB", self._request(protocol.ENCODING, bytes([encoding, frac_bits])))
+        self.drop_bits = self.frac_bits - frac_bits
+
+    @property
+    def sample_bytes(self):
+        return self.info["sample_bytes"]
+
+    @property
+    def frac_bits(self):
+        return self.info["frac_bits"]
+
+    # Inference --------------------------------------------------------------------------------------
+
+    def load_model(self, blob):
+        """Upload a fixed_codegen.py accelerator blob."""
+        self._request(protocol.LOAD_MODEL, bytes(blob))
+
+    def predict_fixed(self, q):
+        """Fixed-point inputs (accelerator Q format) -> fixed-point results.
+        Keeps up to `window` frames in flight so the link stays busy."""
+        q = np.asarray(q, dtype=np.int64).ravel()
+        chunks = [q[i:i + self.frame_samples] for i in range(0, len(q), self.frame_samples)]
+        results = []
+        pending = collections.deque()
+        for chunk in chunks:
+            if len(pending) == self.window:
+                results.extend(self._receive_results(pending.popleft()))
+            pending.append(self._send(protocol.INFER, protocol.pack_samples(chunk, self.sample_bytes)))
+        while pending:
+            results.extend(self._receive_results(pending.popleft()))
+        return np.array(results, dtype=np.int64)
+
+    def _receive_results(self, seq):
+        """Results back in the accelerator Q format (truncated bits are 0)."""
+        payload = self._receive(seq)
+        if self.encoding == protocol.ENC_DELTA:
+            values = protocol.unpack_delta(payload)
+        else:
+            values = protocol.unpack_fixed(payload, self.result_bytes or self.sample_bytes)
+        return [v << self.drop_bits for v in values]
+
+    def predict(self, X):
+        """Real-valued single-feature inputs -> real-valued predictions."""
+        X = np.asarray(X, dtype=np.float64).ravel()
+        scale = float(1 << self.frac_bits)
+        return self.predict_fixed(np.round(X * scale).astype(np.int64)) / scale
+
+    # Measurements -----------------------------------------------------------------------------------
+
+    def measure_throughput(self, n=4096, baudrate=None):
+        q = np.random.RandomState(0).randint(-(1 << self.frac_bits), 1 << self.frac_bits, n)
+        rx_bytes = self.rx_bytes
+        t = time.perf_counter()
+        self.predict_fixed(q)
+        elapsed = time.perf_counter() - t
+        frames = -(-n // self.frame_samples)
+        # The link is full duplex: the busier direction bounds the rate
+        tx_bytes = n * self.sample_bytes + frames * (protocol.HEADER_LEN + protocol.CRC_LEN)
+        link_bytes = max(tx_bytes, self.rx_bytes - rx_bytes)
+        baudrate = baudrate or self.port.baudrate
+        return dict(samples=n, seconds=elapsed, samples_per_s=n / elapsed,
+            reply_bytes_per_sample=(self.rx_bytes - rx_bytes) / n,
+            link_utilization=(link_bytes * 10 / baudrate) / elapsed if baudrate else None)
+
+    def measure_latency(self, n=100, samples=1):
+        """Round trip of single frames, no pipelining (seconds)."""
+        q = np.zeros(samples, dtype=np.int64)
+        lat = []
+        for _ in range(n):
+            t = time.perf_counter()
+            self._receive_results(self._send(protocol.INFER, protocol.pack_samples(q, self.sample_bytes)))
+            lat.append(time.perf_counter() - t)
+        lat = np.array(lat)
+        return dict(mean=lat.mean(), p50=np.percentile(lat, 50), p99=np.percentile(lat, 99), max=lat.max())
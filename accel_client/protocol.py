@@ -0,0 +1,120 @@
+# Binary inference protocol framing (see uart_proto.h)
+
+import binascii
+import struct
+
+SYNC         = 0xa5
+VERSION      = 2
+HEADER_FMT   = "<BBBBH"   # sync, type, seq, flags, length
+HEADER_LEN   = 6
+CRC_LEN      = 2
+MAX_PAYLOAD  = 1024
+
+INFO         = 0x01
+INFER        = 0x02
+EXIT         = 0x03
+LOAD_MODEL   = 0x04
+ENCODING     = 0x05
+REPLY        = 0x80
+ERROR        = 0xff
+
+# Result encodings (ENCODING frame)
+ENC_FIXED    = 0
+ENC_DELTA    = 1
+ENCODINGS    = {"fixed": ENC_FIXED, "delta": ENC_DELTA}
+
+ERRORS = {
+    1: "CRC mismatch",
+    2: "bad length",
+    3: "unknown frame type",
+    4: "accelerator not available",
+    5: "model rejected",
+    6: "unsupported encoding",
+}
+
+MODEL_ERRORS = {
+    1: "not a model blob",
+    2: "bad length",
+    3: "CRC mismatch",
+    4: "fixed-point format differs from the accelerator",
+    5: "degree above the accelerator maximum",
+    6: "accelerator not available",
+}
+
+
+class ProtocolError(Exception):
+    pass
+
+
+def crc16(data):
+    """libbase crc16(): CRC-16/XMODEM."""
+    return binascii.crc_hqx(data, 0)
+
+
+def encode(type, seq, payload=b""):
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError("payload of {} bytes exceeds {}".format(len(payload), MAX_PAYLOAD))
+    body = struct.pack(HEADER_FMT, SYNC, type, seq & 0xff, 0, len(payload)) + payload
+    return body + struct.pack("<H", crc16(body[1:]))
+
+
+def read_frame(port):
+    """Read one frame from `port` (a pyserial object): (type, seq, payload)."""
+    while True:
+        c = port.read(1)
+        if not c:
+            raise ProtocolError("timeout waiting for a frame")
+        if c[0] == SYNC:
+            break
+    header = c + _read_exact(port, HEADER_LEN - 1)
+    _, type, seq, _, length = struct.unpack(HEADER_FMT, header)
+    rest = _read_exact(port, length + CRC_LEN)
+    payload, crc = rest[:length], struct.unpack("<H", rest[length:])[0]
+    if crc != crc16(header[1:] + payload):
+        raise ProtocolError("reply CRC mismatch (seq {})".format(seq))
+    if type == ERROR:
+        code = payload[0] if payload else 0
+        msg = ERRORS.get(code, "error {}".format(code))
+        if code == 5 and len(payload) > 1:
+            msg += ": " + MODEL_ERRORS.get(payload[1], str(payload[1]))
+        raise ProtocolError("firmware: {} (seq {})".format(msg, seq))
+    return type, seq, payload
+
+
+def _read_exact(port, n):
+    data = port.read(n)
+    if len(data) != n:
+        raise ProtocolError("timeout: {} of {} bytes".format(len(data), n))
+    return data
+
+
+def pack_samples(q, sample_bytes):
+    """int array -> little-endian two's complement, sample_bytes each."""
+    mask = (1 << (8 * sample_bytes)) - 1
+    return b"".join((int(v) & mask).to_bytes(sample_bytes, "little") for v in q)
+
+
+def unpack_samples(data, sample_bytes):
+    return [int.from_bytes(data[i:i + sample_bytes], "little", signed=True)
+        for i in range(0, len(data), sample_bytes)]
+
+
+def unpack_fixed(data, result_bytes):
+    """ENC_FIXED results: result_bytes each, sign-extended."""
+    return unpack_samples(data, result_bytes)
+
+
+def unpack_delta(data):
+    """ENC_DELTA results: varints of zig-zag differences, wrapping at 32 bits."""
+    values, value, z, shift = [], 0, 0, 0
+    for b in data:
+        z |= (b & 0x7f) << shift
+        shift += 7
+        if b & 0x80:
+            continue
+        value = (value + ((z >> 1) ^ -(z & 1))) & 0xffffffff
+        values.append(value - (1 << 32) if value & 0x80000000 else value)
+        z, shift = 0, 0
+    if shift:
+        raise ProtocolError("truncated varint in delta reply")
+    return values
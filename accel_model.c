@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <generated/csr.h>
+#include <generated/soc.h>
+#include <libbase/crc.h>
+
+#include "benchmark.h"
+#include "inference_accel.h"
+#include "uart_ring.h"
+#include "accel_model.h"
+
+static struct accel_model_info current;
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+unsigned accel_model_length(const uint8_t *header) {
+    if (get_u32(header) != ACCEL_MODEL_MAGIC || header[4] != ACCEL_MODEL_VERSION)
+        return 0;
+    if (header[7] < 1 || header[7] > ACCEL_MODEL_MAX_COEFFS)
+        return 0;
+    return ACCEL_MODEL_HEADER_LEN + 4 * header[7] + 4;
+}
+
+int accel_model_load(const uint8_t *blob, unsigned len) {
+    unsigned body;
+
+    if (len < ACCEL_MODEL_HEADER_LEN || accel_model_length(blob) == 0)
+        return ACCEL_MODEL_ERR_MAGIC;
+    if (len != accel_model_length(blob))
+        return ACCEL_MODEL_ERR_LENGTH;
+    body = len - 4;
+    if (crc32(blob, body) != get_u32(blob + body))
+        return ACCEL_MODEL_ERR_CRC;
+
+#ifdef CSR_INFERENCE_ACCEL_BASE
+    int32_t coeffs[ACCEL_MODEL_MAX_COEFFS] = { 0 };
+    unsigned n = blob[7], degree = n < 2 ? 1 : n - 1, i;
+
+    if (blob[6] != INFERENCE_ACCEL_FRAC_BITS)
+        return ACCEL_MODEL_ERR_FORMAT;
+    if (degree > INFERENCE_ACCEL_MAX_DEGREE)
+        return ACCEL_MODEL_ERR_DEGREE;
+
+    // Linear blobs are [bias, weight], a lone c0 runs as degree 1 with c1 = 0
+    for (i = 0; i < n; i++) {
+        coeffs[i] = (int32_t)get_u32(blob + ACCEL_MODEL_HEADER_LEN + 4 * i);
+    }
+    inference_accel_set_poly(coeffs, degree);
+
+    current.kind = blob[5];
+    current.frac_bits = blob[6];
+    current.degree = degree;
+    current.crc32 = get_u32(blob + body);
+    return 0;
+#else
+    return ACCEL_MODEL_ERR_NO_ACCEL;
+#endif
+}
+
+// Blocking read with a per-byte timeout on timer0
+static int read_byte(uint8_t *c, uint32_t timeout_ticks) {
+    uint32_t t = stopwatch_ticks();
+    int r;
+
+    while ((r = uart_ring_getc_nonblock()) < 0) {
+        if (t - stopwatch_ticks() > timeout_ticks)
+            return ACCEL_MODEL_ERR_TIMEOUT;
+    }
+    *c = r;
+    return 0;
+}
+
+int accel_model_load_uart(void) {
+    const uint32_t timeout = (CONFIG_CLOCK_FREQUENCY / 1000) * ACCEL_MODEL_TIMEOUT_MS;
+    static uint8_t blob[ACCEL_MODEL_MAX_LEN];
+    unsigned i, len = ACCEL_MODEL_HEADER_LEN;
+    int err;
+
+    stopwatch_init(); // free-running timer0 for the timeout
+    // readstr() returns on the first CR or LF of the command line, skip the
+    // rest of a CR LF line ending so it is not taken as the first blob byte
+    do {
+        if ((err = read_byte(&blob[0], timeout)) != 0)
+            return err;
+    } while (blob[0] == '\r' || blob[0] == '\n');
+    for (i = 1; i < len; i++) {
+        if ((err = read_byte(&blob[i], timeout)) != 0)
+            return err;
+        if (i == ACCEL_MODEL_HEADER_LEN - 1) {
+            len = accel_model_length(blob);
+            if (len == 0)
+                return ACCEL_MODEL_ERR_MAGIC;
+        }
+    }
+
+    return accel_model_load(blob, len);
+}
+
+const struct accel_model_info *accel_model_current(void) {
+    return current.degree ? &current : NULL;
+}
+
+const char *accel_model_strerror(int err) {
+    switch (err) {
+        case 0:                        return "ok";
+        case ACCEL_MODEL_ERR_MAGIC:    return "not a model blob";
+        case ACCEL_MODEL_ERR_LENGTH:   return "bad length";
+        case ACCEL_MODEL_ERR_CRC:      return "CRC mismatch";
+        case ACCEL_MODEL_ERR_FORMAT:   return "fixed-point format differs from the accelerator";
+        case ACCEL_MODEL_ERR_DEGREE:   return "degree above the accelerator maximum";
+        case ACCEL_MODEL_ERR_NO_ACCEL: return "accelerator not available";
+        case ACCEL_MODEL_ERR_TIMEOUT:  return "timeout";
+        default:                       return "unknown error";
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef __ACCEL_MODEL_H
+#define __ACCEL_MODEL_H
+
+#include <stdint.h>
+
+// Runtime accelerator model loading
+//
+// Models are the parameter blobs written by fixed_codegen.py (export(...,
+// blob_path=...) for linear models, export_polynomial() for polynomials):
+//   u32 magic, u8 version, u8 kind, u8 frac_bits, u8 n_coeffs,
+//   i32 coeffs[n_coeffs] (ascending powers of x), u32 crc32 of the above
+// A verified blob is written into the accelerator coefficient bank, so a new
+// model only needs an upload instead of a rebuild and reboot.
+
+#define ACCEL_MODEL_MAGIC        0x444d4149 // "IAMD"
+#define ACCEL_MODEL_VERSION      1
+#define ACCEL_MODEL_KIND_LINEAR  0
+#define ACCEL_MODEL_KIND_POLY    1
+#define ACCEL_MODEL_HEADER_LEN   8
+#define ACCEL_MODEL_MAX_COEFFS   16
+#define ACCEL_MODEL_MAX_LEN      (ACCEL_MODEL_HEADER_LEN + 4 * ACCEL_MODEL_MAX_COEFFS + 4)
+
+// Upload timeout for the load-model command (between two bytes)
+#define ACCEL_MODEL_TIMEOUT_MS   5000
+
+#define ACCEL_MODEL_ERR_MAGIC    -1
+#define ACCEL_MODEL_ERR_LENGTH   -2
+#define ACCEL_MODEL_ERR_CRC      -3
+#define ACCEL_MODEL_ERR_FORMAT   -4 // Q format differs from the accelerator's
+#define ACCEL_MODEL_ERR_DEGREE   -5 // more coefficients than the accelerator has
+#define ACCEL_MODEL_ERR_NO_ACCEL -6
+#define ACCEL_MODEL_ERR_TIMEOUT  -7
+
+struct accel_model_info {
+    uint8_t kind;
+    uint8_t frac_bits;
+    uint8_t degree;
+    uint32_t crc32;
+};
+
+// Total blob length from its header (0 when the header is not valid)
+unsigned accel_model_length(const uint8_t *header);
+int accel_model_load(const uint8_t *blob, unsigned len);
+// Receive a blob on the UART (after the command line) and load it
+int accel_model_load_uart(void);
+const struct accel_model_info *accel_model_current(void);
+const char *accel_model_strerror(int err);
+
+#endif // __ACCEL_MODEL_H
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "inference_accel.h"
+#include "accel_pipeline.h"
+#include "dlog.h"
+
+#if defined(CSR_INFERENCE_ACCEL_BASE) && defined(INFERENCE_ACCEL_MEM_BASE)
+
+static void pipeline_prepare(accel_prepare_fn prepare, void *ctx, unsigned bank,
+                             unsigned first, unsigned count, struct accel_pipeline_stats *st) {
+    volatile int32_t *in = inference_accel_batch_inputs(bank);
+    uint32_t t = stopwatch_ticks();
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        in[i] = prepare(first + i, ctx);
+    }
+
+    st->prepare_ticks += t - stopwatch_ticks();
+}
+
+static void pipeline_consume(accel_consume_fn consume, void *ctx, unsigned bank,
+                             unsigned first, unsigned count, struct accel_pipeline_stats *st) {
+    volatile int32_t *out = inference_accel_batch_results(bank);
+    uint32_t t = stopwatch_ticks();
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        consume(first + i, inference_accel_sign_extend(out[i]), ctx);
+    }
+
+    st->consume_ticks += t - stopwatch_ticks();
+}
+
+static void pipeline_wait(struct accel_pipeline_stats *st) {
+    uint32_t t = stopwatch_ticks();
+
+    inference_accel_batch_wait();
+    st->wait_ticks += t - stopwatch_ticks();
+}
+
+int accel_pipeline_run(accel_prepare_fn prepare, accel_consume_fn consume, void *ctx,
+                       unsigned n, int overlap, struct accel_pipeline_stats *st) {
+    const unsigned depth = INFERENCE_ACCEL_BATCH_DEPTH;
+    unsigned first, count, prev_first = 0, prev_count = 0, bank = 0;
+    uint32_t t;
+
+    memset(st, 0, sizeof(*st));
+    t = stopwatch_ticks();
+
+    for (first = 0; first < n; first += depth) {
+        count = (n - first < depth) ? n - first : depth;
+
+        if (!overlap) {
+            pipeline_prepare(prepare, ctx, 0, first, count, st);
+            inference_accel_batch_start(0, count);
+            pipeline_wait(st);
+            pipeline_consume(consume, ctx, 0, first, count, st);
+            st->batches++;
+            continue;
+        }
+
+        // Accelerator still busy with the previous batch in the other bank
+        pipeline_prepare(prepare, ctx, bank, first, count, st);
+        if (prev_count) {
+            pipeline_wait(st);
+        }
+        inference_accel_batch_start(bank, count);
+        if (prev_count) {
+            pipeline_consume(consume, ctx, bank ^ 1, prev_first, prev_count, st);
+        }
+
+        prev_first = first;
+        prev_count = count;
+        bank ^= 1;
+        st->batches++;
+    }
+
+    if (overlap && prev_count) {
+        pipeline_wait(st);
+        pipeline_consume(consume, ctx, bank ^ 1, prev_first, prev_count, st);
+    }
+
+    st->total_ticks = t - stopwatch_ticks();
+    return 0;
+}
+
+#else
+
+int accel_pipeline_run(accel_prepare_fn prepare, accel_consume_fn consume, void *ctx,
+                       unsigned n, int overlap, struct accel_pipeline_stats *st) {
+    memset(st, 0, sizeof(*st));
+    return -1;
+}
+
+#endif
+
+void accel_pipeline_report(const struct accel_pipeline_stats *seq, const struct accel_pipeline_stats *pipe) {
+    uint32_t cpu = pipe->prepare_ticks + pipe->consume_ticks;
+    uint32_t saved = seq->total_ticks > pipe->total_ticks ? seq->total_ticks - pipe->total_ticks : 0;
+
+    dlog_printf("=== Pipeline Results ===\n");
+#ifdef INFERENCE_ACCEL_BATCH_DEPTH
+    dlog_printf("Batches: %lu of up to %d samples\n", (unsigned long)pipe->batches, INFERENCE_ACCEL_BATCH_DEPTH);
+#endif
+    dlog_printf("Sequential ticks: %lu (prepare %lu, consume %lu, wait %lu)\n",
+                (unsigned long)seq->total_ticks, (unsigned long)seq->prepare_ticks,
+                (unsigned long)seq->consume_ticks, (unsigned long)seq->wait_ticks);
+    dlog_printf("Pipelined ticks:  %lu (prepare %lu, consume %lu, wait %lu)\n",
+                (unsigned long)pipe->total_ticks, (unsigned long)pipe->prepare_ticks,
+                (unsigned long)pipe->consume_ticks, (unsigned long)pipe->wait_ticks);
+    // Overlap: share of the sequential accelerator wait hidden behind CPU work
+    if (seq->wait_ticks) {
+        uint32_t hidden = seq->wait_ticks > pipe->wait_ticks ? seq->wait_ticks - pipe->wait_ticks : 0;
+        dlog_printf("Achieved overlap: %lu%% of accelerator time hidden behind %lu CPU ticks\n",
+                    (unsigned long)((uint64_t)hidden * 100 / seq->wait_ticks), (unsigned long)cpu);
+    }
+    dlog_printf("Ticks saved by pipelining: %lu\n\n", (unsigned long)saved);
+}
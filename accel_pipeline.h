@@ -0,0 +1,30 @@
+#ifndef __ACCEL_PIPELINE_H
+#define __ACCEL_PIPELINE_H
+
+#include <stdint.h>
+
+// Double-buffered CPU/accelerator batch runner
+//
+// The CPU prepares batch k+1 (fetch, convert, pack) into one bank of the
+// accelerator sample memory while the accelerator processes batch k from
+// the other bank; results of batch k are consumed after batch k+1 starts.
+
+// Returns the fixed-point input for sample `index`
+typedef int32_t (*accel_prepare_fn)(unsigned index, void *ctx);
+// Receives the fixed-point result of sample `index`
+typedef void (*accel_consume_fn)(unsigned index, int32_t result, void *ctx);
+
+struct accel_pipeline_stats {
+    uint32_t total_ticks;
+    uint32_t prepare_ticks;     // CPU preparing inputs
+    uint32_t consume_ticks;     // CPU consuming results
+    uint32_t wait_ticks;        // CPU idle, waiting for the accelerator
+    uint32_t batches;
+};
+
+// overlap = 0 runs the same batches strictly sequentially (reference)
+int accel_pipeline_run(accel_prepare_fn prepare, accel_consume_fn consume, void *ctx,
+                       unsigned n, int overlap, struct accel_pipeline_stats *st);
+void accel_pipeline_report(const struct accel_pipeline_stats *seq, const struct accel_pipeline_stats *pipe);
+
+#endif // __ACCEL_PIPELINE_H
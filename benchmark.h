@@ -0,0 +1,45 @@
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include <stdint.h>
+#include <generated/csr.h>
+
+// Stopwatch on timer0 (diabetes_litex.c), shared by the benchmark commands
+extern uint32_t start_ticks;
+extern uint32_t elapsed_ticks;
+
+// Free-running timer0 for stopwatch_ticks(), without a measurement (dlog keeps
+// blocking instead of dropping)
+void stopwatch_init(void);
+void start_stopwatch(void);
+void stop_stopwatch(void);
+void print_elapsed_time(uint32_t ticks, const char* benchmark_name);
+
+// Current timer0 value; the timer counts down, so elapsed = earlier - later
+static inline uint32_t stopwatch_ticks(void) {
+    timer0_update_value_write(1);
+    return timer0_value_read();
+}
+
+// Cycles since reset (timer0 uptime, SoC built with --timer-uptime), 0 without it
+static inline uint64_t uptime_cycles(void) {
+#ifdef CSR_TIMER0_UPTIME_CYCLES_ADDR
+    timer0_uptime_latch_write(1);
+    return timer0_uptime_cycles_read();
+#else
+    return 0;
+#endif
+}
+
+// Console benchmarks run as a scheduler task: *_start() checks and sets up,
+// then every *_step() call runs one engine (flash: one chunk) and returns
+// zero once the results are logged. Each measured region still runs in a
+// single call, the scheduler only gets in between engines.
+int benchmark_start(void);
+int benchmark_step(void);
+int digits_benchmark_start(void);
+int digits_benchmark_step(void);
+int flash_benchmark_start(const char *name);
+int flash_benchmark_step(void);
+
+#endif // __BENCHMARK_H
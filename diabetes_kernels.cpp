@@ -0,0 +1,20 @@
+#include "diabetes_kernels.h"
+#include "inference_kernels.hpp"
+#include "diabetes_model.h"
+
+// y = x * DIABETES_WEIGHT + DIABETES_BIAS, everything Q16.16
+typedef ik::LinearRegressor<
+    ik::Q<16>, ik::Q<16>, ik::Q<16>,
+    ik::Q<16>::from(DIABETES_BIAS),
+    ik::Row<ik::Q<16>::from(DIABETES_WEIGHT)>
+> DiabetesRegressor;
+
+static_assert(DiabetesRegressor::features == 1, "diabetes model uses one feature");
+
+extern "C" int32_t diabetes_tmpl_predict(int32_t x_fixed) {
+    return DiabetesRegressor::predict(&x_fixed);
+}
+
+extern "C" void diabetes_tmpl_predict_batch(const int32_t *x, int32_t *y, unsigned n) {
+    DiabetesRegressor::predict_batch(x, y, n);
+}
@@ -0,0 +1,19 @@
+#ifndef __DIABETES_KERNELS_H
+#define __DIABETES_KERNELS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Diabetes regressor specialised through inference_kernels.hpp
+// Input and result are Q16.16.
+int32_t diabetes_tmpl_predict(int32_t x_fixed);
+void diabetes_tmpl_predict_batch(const int32_t *x, int32_t *y, unsigned n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __DIABETES_KERNELS_H
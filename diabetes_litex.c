@@ -6,19 +6,41 @@
 #include <libbase/uart.h>
 #include <libbase/console.h>
 
+#include "benchmark.h"
 #include "inference_accel.h"
+#include "fixed_kernels.h"
+#include "diabetes_kernels.h"
+#include "diabetes_model.h"
+#include "flash_data.h"
+#include "accel_pipeline.h"
+#include "uart_proto.h"
+#include "uart_ring.h"
+#include "accel_model.h"
+#include "sched.h"
+#include "dlog.h"
+#include "main_ram.h"
+
+// Polynomial fit written by lgr_poly.py
+#if __has_include("diabetes_poly.h")
+#define DIABETES_POLY_AVAILABLE
+#include "diabetes_poly.h"
+// Interpolated table of the same polynomial, also written by lgr_poly.py
+#if __has_include("diabetes_lut.h")
+#define DIABETES_LUT_AVAILABLE
+#include "diabetes_lut.h"
+#endif
+#endif
+#if !defined(DIABETES_LUT_AVAILABLE)
+#warning "diabetes_poly.h/diabetes_lut.h missing (make runs lgr_poly.py): no polynomial and LUT engines"
+#endif
 
 uint32_t start_ticks;
 uint32_t elapsed_ticks;
 
-void start_stopwatch(void);
-void stop_stopwatch(void);
-void print_elapsed_time(uint32_t ticks, const char* benchmark_name);
 double predict(double x);
 int predict_int(double x);
-int benchmark(void);
 
-void start_stopwatch(void) {
+void stopwatch_init(void) {
     // Disable timer
     timer0_en_write(0);
     
@@ -28,10 +50,18 @@ void start_stopwatch(void) {
     
     // Enable timer
     timer0_en_write(1);
+}
+
+void start_stopwatch(void) {
+    // Console output already queued would go out from the UART interrupt
+    // inside the measured region, so let it drain first
+    uart_ring_flush();
+    stopwatch_init();
     
     // Update and read initial value
     timer0_update_value_write(1);
     start_ticks = timer0_value_read();
+    dlog_set_measuring(1);
 }
 
 void stop_stopwatch(void) {
@@ -43,9 +73,10 @@ void stop_stopwatch(void) {
     
     // Calculate elapsed ticks (timer counts down)
     elapsed_ticks = start_ticks - end_ticks;
+    dlog_set_measuring(0);
 }
 
-// Print elapsed time without using floats
+// Log elapsed time without using floats (deferred, see dlog.h)
 void print_elapsed_time(uint32_t ticks, const char* benchmark_name) {
     // Convert ticks to microseconds first, then to milliseconds
     uint32_t microseconds = ticks / (CONFIG_CLOCK_FREQUENCY / 1000000);
@@ -56,119 +87,352 @@ void print_elapsed_time(uint32_t ticks, const char* benchmark_name) {
     uint32_t rem_milliseconds = milliseconds % 1000;
     uint32_t MHz = CONFIG_CLOCK_FREQUENCY / 1000000;
     
-    printf("=== %s Results ===\n", benchmark_name);
-    printf("Raw ticks: %lu\n", ticks);
-    printf("Elapsed time: %02d:%02d.%03d (%lu milliseconds)\n", 
-           (int)minutes, (int)rem_seconds, (int)rem_milliseconds, (unsigned long)milliseconds);
-    printf("CPU: %s @ %luMHz\n", CONFIG_CPU_HUMAN_NAME, (unsigned long)MHz);
-    printf("Clock frequency: %lu Hz\n", (unsigned long)CONFIG_CLOCK_FREQUENCY);
-    printf("\n");
+    dlog_printf("=== %s Results ===\n", benchmark_name);
+    dlog_printf("Raw ticks: %lu\n", (unsigned long)ticks);
+    dlog_printf("Elapsed time: %02d:%02d.%03d (%lu milliseconds)\n", 
+                (int)minutes, (int)rem_seconds, (int)rem_milliseconds, (unsigned long)milliseconds);
+    dlog_printf("CPU: %s @ %luMHz\n", CONFIG_CPU_HUMAN_NAME, (unsigned long)MHz);
+    dlog_printf("Clock frequency: %lu Hz\n", (unsigned long)CONFIG_CLOCK_FREQUENCY);
+    dlog_printf("\n");
 }
 
 // Software prediction functions
 double predict(double x) {
-    return x * 938.237861251353 + 152.91886182616113;
+    return x * DIABETES_WEIGHT + DIABETES_BIAS;
 }
 
 int predict_int(double x) {
     return (((int)(x * 100)) * 93823 + 1529188) / 100;
 }
 
-int benchmark(void) {
-    puts("LiteX Benchmark with Hardware Accelerator Starting...\n");
+#if defined(CSR_INFERENCE_ACCEL_BASE) && defined(INFERENCE_ACCEL_MEM_BASE)
+// Pipeline benchmark: BMI inputs converted to fixed point by the CPU
+static const double pipeline_inputs[8] = {
+    0.0617, -0.0515, 0.0445, -0.0116, -0.0364, -0.0407, -0.0472, -0.0019,
+};
+
+static int32_t pipeline_prepare(unsigned index, void *ctx) {
+    return FLOAT_TO_FIXED(pipeline_inputs[index & 7]);
+}
+
+static void pipeline_consume(unsigned index, int32_t result, void *ctx) {
+    *(int32_t *)ctx += result >> INFERENCE_ACCEL_FRAC_BITS;
+}
+#endif
+
+enum {
+    BENCH_STEP_FP,
+    BENCH_STEP_INT,
+    BENCH_STEP_FX,
+    BENCH_STEP_FX_BATCH,
+    BENCH_STEP_TMPL,
+    BENCH_STEP_HW,
+    BENCH_STEP_HW_PIPELINE,
+    BENCH_STEP_POLY,
+    BENCH_STEP_LUT,
+    BENCH_STEP_HW_POLY,
+    BENCH_STEP_REPORT,
+};
+
+// Benchmark in progress, one engine per benchmark_step()
+static struct {
+    int step;
+    volatile double p1;
+    volatile int p2;
+    volatile int p3;            // Hardware accelerator results
+    volatile int32_t p4;        // CPU fixed-point kernel results
+    volatile int32_t p5;        // CPU fixed-point batch kernel results
+    volatile int32_t p6;        // CPU C++ template kernel results
+} bench;
+
+#define BENCH_INPUT 0.03        // valor da feature
+
+int benchmark_start(void) {
+    dlog_printf("LiteX Benchmark with Hardware Accelerator Starting...\n\n");
     
-    double input = 0.03; // valor da feature
-    volatile double p1 = 0;
-    volatile int p2 = 0;
-    int i;
+    bench.step = BENCH_STEP_FP;
+    bench.p1 = 0;
+    bench.p2 = 0;
+    bench.p3 = 0;
+    bench.p4 = 0;
+    bench.p5 = 0;
+    bench.p6 = 0;
     
     // Initialize hardware accelerator
 #ifdef CSR_INFERENCE_ACCEL_BASE
-    volatile int p3 = 0; // Hardware accelerator results
-    printf("Initializing inference accelerator...\n");
+    dlog_printf("Initializing inference accelerator...\n");
     inference_accel_init();
-    inference_accel_set_params(938.237861251353, 152.91886182616113);
-    printf("Hardware accelerator initialized!\n\n");
+    inference_accel_set_params(DIABETES_WEIGHT, DIABETES_BIAS);
+    dlog_printf("Hardware accelerator initialized!\n\n");
 #else
-    printf("Warning: Inference accelerator not available in this build\n\n");
-#endif
-    
-    // First benchmark - floating point prediction (CPU)
-    printf("Running CPU floating point benchmark...\n");
-    start_stopwatch();
-    
-    for (i = 0; i < 100000; i += 1) {
-        p1 += predict(input);
-    }
-    
-    stop_stopwatch();
-    print_elapsed_time(elapsed_ticks, "CPU Floating Point Benchmark");
-    
-    // Second benchmark - integer prediction (CPU)
-    printf("Running CPU integer benchmark...\n");
-    start_stopwatch();
-    
-    for (i = 0; i < 100000; i += 1) {
-        p2 += predict_int(input);
-    }
-    
-    stop_stopwatch();
-    print_elapsed_time(elapsed_ticks, "CPU Integer Benchmark");
-    
-    // Third benchmark - hardware accelerated prediction
-#ifdef CSR_INFERENCE_ACCEL_BASE
-    printf("Running hardware accelerated benchmark...\n");
-    start_stopwatch();
-    
-    for (i = 0; i < 100000; i += 1) {
-        int32_t hw_result = inference_accel_compute(input);
-        p3 += (hw_result >> 16); // Convert from Q16.16 to integer for accumulation
-    }
-    
-    stop_stopwatch();
-    print_elapsed_time(elapsed_ticks, "Hardware Accelerated Benchmark");
+    dlog_printf("Warning: Inference accelerator not available in this build\n\n");
 #endif
+    return 0;
+}
+
+static void benchmark_report(void) {
+    double input = BENCH_INPUT;
+    int32_t input_fixed = FX_CONST(BENCH_INPUT, 16);
     
-    printf("=== Final Results ===\n");
-    printf("CPU FP accumulated result: %.6f\n", p1);
-    printf("CPU INT accumulated result: %d\n", p2 / 100);
+    dlog_printf("=== Final Results ===\n");
+    dlog_printf("CPU FP accumulated result: %.6f\n", bench.p1);
+    dlog_printf("CPU INT accumulated result: %d\n", bench.p2 / 100);
+    dlog_printf("CPU FX accumulated result: %ld\n", (long)bench.p4);
+    dlog_printf("CPU FX batch accumulated result: %ld\n", (long)bench.p5);
+    dlog_printf("CPU C++ template accumulated result: %ld\n", (long)bench.p6);
 #ifdef CSR_INFERENCE_ACCEL_BASE
-    printf("HW accelerated accumulated result: %d\n", p3);
+    dlog_printf("HW accelerated accumulated result: %d\n", bench.p3);
 #endif
     
     // Single prediction comparison
-    printf("\n=== Single Prediction Comparison ===\n");
+    dlog_printf("\n=== Single Prediction Comparison ===\n");
     double single_fp = predict(input);
     int single_int = predict_int(input);
     
-    printf("CPU FP single prediction: %.6f\n", single_fp);
-    printf("CPU INT single prediction: %d\n", single_int);
+    dlog_printf("CPU FP single prediction: %.6f\n", single_fp);
+    dlog_printf("CPU INT single prediction: %d\n", single_int);
+    
+    int32_t single_fx = fx_linear1(input_fixed, DIABETES_WEIGHT_Q16, DIABETES_BIAS_Q16, 16);
+    dlog_printf("CPU FX single prediction (fixed): %ld\n", (long)single_fx);
+    dlog_printf("CPU FX single prediction (float): %.6f\n", single_fx / 65536.0);
+    dlog_printf("CPU C++ template single prediction (fixed): %ld\n", (long)diabetes_tmpl_predict(input_fixed));
     
 #ifdef CSR_INFERENCE_ACCEL_BASE
     // Test single hardware prediction
     int32_t hw_single = inference_accel_compute(input);
     double hw_single_float = inference_accel_get_result_float();
     
-    printf("HW single prediction (fixed): %ld\n", (long)hw_single);
-    printf("HW single prediction (float): %.6f\n", hw_single_float);
+    dlog_printf("HW single prediction (fixed): %ld\n", (long)hw_single);
+    dlog_printf("HW single prediction (float): %.6f\n", hw_single_float);
     
     // Accuracy comparison
     double hw_error = hw_single_float - single_fp;
-    printf("HW vs CPU FP error: %.6f\n", hw_error);
+    dlog_printf("HW vs CPU FP error: %.6f\n", hw_error);
 #endif
     
-    printf("\n=== Performance Analysis ===\n");
-    printf("- CPU Floating point: highest precision, potentially slower\n");
-    printf("- CPU Integer: faster than FP, reduced precision\n");
+    dlog_printf("\n=== Performance Analysis ===\n");
+    dlog_printf("- CPU Floating point: highest precision, potentially slower\n");
+    dlog_printf("- CPU Integer: faster than FP, reduced precision\n");
+    dlog_printf("- CPU Fixed-point kernels: Q16.16, shifts only, no division (accelerator fallback)\n");
+    dlog_printf("- CPU C++ template kernel: same math, weights folded in at compile time\n");
+#ifdef DIABETES_POLY_AVAILABLE
+    dlog_printf("- Polynomial: Horner scheme, one multiply-add per degree (accelerator: one per stage)\n");
+#endif
+#ifdef DIABETES_LUT_AVAILABLE
+    dlog_printf("- CPU LUT: interpolated table, works for any bounded single-feature model\n");
+#endif
 #ifdef CSR_INFERENCE_ACCEL_BASE
-    printf("- Hardware accelerator: dedicated pipeline, fixed-point arithmetic\n");
-    printf("- HW accelerator should show significant speedup for large batches\n");
+    dlog_printf("- Hardware accelerator: dedicated pipeline, fixed-point arithmetic\n");
+    dlog_printf("- HW accelerator should show significant speedup for large batches\n");
 #endif
     
-    printf("\nBenchmark completed!\n");
-    return 0;
+    dlog_printf("\nBenchmark completed!\n");
+    dlog_flush();
 }
 
+int benchmark_step(void) {
+    double input = BENCH_INPUT;
+    int32_t input_fixed = FX_CONST(BENCH_INPUT, 16);
+    static int32_t batch_in[FX_BATCH_SIZE];
+    static int32_t batch_out[FX_BATCH_SIZE];
+#ifdef DIABETES_POLY_AVAILABLE
+    int32_t poly_input = FX_CONST(BENCH_INPUT, DIABETES_POLY_FRAC_BITS);
+#endif
+    int i, j, n;
+    
+    switch (bench.step++) {
+    case BENCH_STEP_FP:
+        // First benchmark - floating point prediction (CPU)
+        dlog_printf("Running CPU floating point benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            bench.p1 += predict(input);
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU Floating Point Benchmark");
+        return 1;
+    
+    case BENCH_STEP_INT:
+        // Second benchmark - integer prediction (CPU)
+        dlog_printf("Running CPU integer benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            bench.p2 += predict_int(input);
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU Integer Benchmark");
+        return 1;
+    
+    case BENCH_STEP_FX:
+        // Fixed-point kernel benchmark - Q16.16 input, shift instead of divide (CPU)
+        dlog_printf("Running CPU fixed-point kernel benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            bench.p4 += fx_linear1(input_fixed, DIABETES_WEIGHT_Q16, DIABETES_BIAS_Q16, 16) >> 16;
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU Fixed-Point Kernel Benchmark");
+        return 1;
+    
+    case BENCH_STEP_FX_BATCH:
+        // Same kernel through the batch entry point
+        for (j = 0; j < FX_BATCH_SIZE; j++) {
+            batch_in[j] = input_fixed;
+        }
+        
+        dlog_printf("Running CPU fixed-point batch kernel benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += n) {
+            // Short last batch, so it runs the same 100000 samples as the other engines
+            n = 100000 - i < FX_BATCH_SIZE ? 100000 - i : FX_BATCH_SIZE;
+            fx_linear1_batch(DIABETES_WEIGHT_Q16, DIABETES_BIAS_Q16, 16, batch_in, batch_out, n);
+            for (j = 0; j < n; j++) {
+                bench.p5 += batch_out[j] >> 16;
+            }
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU Fixed-Point Batch Kernel Benchmark");
+        return 1;
+    
+    case BENCH_STEP_TMPL:
+        // C++ template kernel - weights are compile-time constants (CPU)
+        dlog_printf("Running CPU C++ template kernel benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            bench.p6 += diabetes_tmpl_predict(input_fixed) >> 16;
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU C++ Template Kernel Benchmark");
+        return 1;
+    
+#ifdef CSR_INFERENCE_ACCEL_BASE
+    case BENCH_STEP_HW:
+        // Third benchmark - hardware accelerated prediction
+        dlog_printf("Running hardware accelerated benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            int32_t hw_result = inference_accel_compute(input);
+            bench.p3 += (hw_result >> INFERENCE_ACCEL_FRAC_BITS); // Convert from fixed point to integer for accumulation
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "Hardware Accelerated Benchmark");
+        return 1;
+    
+#ifdef INFERENCE_ACCEL_MEM_BASE
+    case BENCH_STEP_HW_PIPELINE: {
+        // Batch mode - CPU prepares the next batch while the accelerator runs
+        struct accel_pipeline_stats seq_stats, pipe_stats;
+        int32_t seq_sum = 0, pipe_sum = 0;
+        
+        dlog_printf("Running hardware batch pipeline benchmark...\n");
+        start_stopwatch();
+        accel_pipeline_run(pipeline_prepare, pipeline_consume, &seq_sum, 100000, 0, &seq_stats);
+        // Per-phase log inside the measured region: a ring copy, no UART wait
+        dlog_printf("Sequential phase: %lu batches, %lu ticks\n",
+                    (unsigned long)seq_stats.batches, (unsigned long)seq_stats.total_ticks);
+        accel_pipeline_run(pipeline_prepare, pipeline_consume, &pipe_sum, 100000, 1, &pipe_stats);
+        dlog_printf("Pipelined phase: %lu batches, %lu ticks\n",
+                    (unsigned long)pipe_stats.batches, (unsigned long)pipe_stats.total_ticks);
+        stop_stopwatch();
+        accel_pipeline_report(&seq_stats, &pipe_stats);
+        dlog_printf("Pipeline accumulated results: sequential %ld, pipelined %ld\n\n", (long)seq_sum, (long)pipe_sum);
+        return 1;
+    }
+#endif
+#endif
+    
+#ifdef DIABETES_POLY_AVAILABLE
+    case BENCH_STEP_POLY: {
+        // Polynomial fit - Horner on the CPU, then on the accelerator pipeline
+        volatile int32_t p8 = 0;
+        
+        dlog_printf("Running CPU polynomial (degree %d) benchmark...\n", DIABETES_POLY_DEGREE);
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            p8 += diabetes_poly_predict(poly_input) >> DIABETES_POLY_FRAC_BITS;
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU Polynomial Benchmark");
+        dlog_printf("CPU polynomial accumulated result: %ld\n", (long)p8);
+        return 1;
+    }
+    
+#ifdef DIABETES_LUT_AVAILABLE
+    case BENCH_STEP_LUT: {
+        // LUT interpolation of the same polynomial - table generated by lut_codegen.py (CPU)
+        int32_t lut_input = FX_CONST(BENCH_INPUT, DIABETES_LUT_IN_FRAC_BITS);
+        volatile int32_t p7 = 0;
+        
+        dlog_printf("Running CPU LUT interpolation benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            p7 += lut_interp(&diabetes_lut, lut_input) >> DIABETES_LUT_OUT_FRAC_BITS;
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "CPU LUT Interpolation Benchmark");
+        dlog_printf("CPU LUT accumulated result: %ld\n", (long)p7);
+        dlog_printf("LUT single prediction (fixed): %ld, polynomial %ld (table error bound %s)\n\n",
+                    (long)lut_interp(&diabetes_lut, lut_input), (long)diabetes_poly_predict(poly_input),
+                    DIABETES_LUT_MAX_ERROR);
+        return 1;
+    }
+#endif
+    
+    case BENCH_STEP_HW_POLY: {
+#if defined(CSR_INFERENCE_ACCEL_BASE) && DIABETES_POLY_DEGREE <= INFERENCE_ACCEL_MAX_DEGREE && \
+    DIABETES_POLY_FRAC_BITS == INFERENCE_ACCEL_FRAC_BITS
+        volatile int32_t p9 = 0;
+        
+        inference_accel_set_poly(diabetes_poly_coeffs, DIABETES_POLY_DEGREE);
+        dlog_printf("Running hardware polynomial benchmark...\n");
+        start_stopwatch();
+        
+        for (i = 0; i < 100000; i += 1) {
+            p9 += inference_accel_compute_fixed(poly_input) >> INFERENCE_ACCEL_FRAC_BITS;
+        }
+        
+        stop_stopwatch();
+        print_elapsed_time(elapsed_ticks, "Hardware Polynomial Benchmark");
+        dlog_printf("HW polynomial accumulated result: %ld\n", (long)p9);
+        dlog_printf("Polynomial single prediction (fixed): CPU %ld, HW %ld\n\n",
+                    (long)diabetes_poly_predict(poly_input), (long)inference_accel_compute_fixed(poly_input));
+        
+        // Back to the linear model for the comparisons below
+        inference_accel_set_params(DIABETES_WEIGHT, DIABETES_BIAS);
+        inference_accel_degree_write(1);
+#else
+        dlog_printf("Polynomial not run on the accelerator (needs degree %d, Q%d.%d)\n\n",
+                    DIABETES_POLY_DEGREE, 32 - DIABETES_POLY_FRAC_BITS, DIABETES_POLY_FRAC_BITS);
+#endif
+        return 1;
+    }
+#endif
+    
+    case BENCH_STEP_REPORT:
+        benchmark_report();
+        return 0;
+    
+    default:
+        // Engine not built in
+        return bench.step <= BENCH_STEP_REPORT;
+    }
+}
 
 /*-----------------------------------------------------------------------*/
 /* Uart                                                                  */
@@ -179,9 +443,11 @@ static char *readstr(void)
 	char c[2];
 	static char s[64];
 	static int ptr = 0;
+	int r;
 
-	if(readchar_nonblock()) {
-		c[0] = getchar();
+	r = uart_ring_getc_nonblock();
+	if(r >= 0) {
+		c[0] = r;
 		c[1] = 0;
 		switch(c[0]) {
 			case 0x7f:
@@ -245,6 +511,13 @@ static void help(void)
 	puts("reboot                            - Reboot CPU");
 	puts("hello                             - Hello world");
     puts("benchmark                         - benchmark");
+    puts("digits                            - digits classifier benchmark");
+    puts("flash                             - list SPI flash data entries");
+    puts("stream <name>                     - stream a flash data entry through inference");
+    puts("binary                            - binary inference protocol (see uart_proto.h)");
+    puts("load-model                        - upload an accelerator model blob (fixed_codegen.py)");
+    puts("tasks                             - scheduler task statistics");
+    puts("boot                              - time from reset to the first inference");
 }
 
 
@@ -264,17 +537,95 @@ static void helloc_cmd(void)
 }
 
 
+static void load_model_cmd(void)
+{
+	const struct accel_model_info *m;
+	int err;
+
+	printf("Send the model blob (up to %d bytes)...\n", ACCEL_MODEL_MAX_LEN);
+	err = accel_model_load_uart();
+	if(err != 0) {
+		printf("Model not loaded: %s\n", accel_model_strerror(err));
+		return;
+	}
+	m = accel_model_current();
+	printf("Model loaded: %s, degree %d, Q%d.%d, crc32 %08lx\n",
+	       m->kind == ACCEL_MODEL_KIND_POLY ? "polynomial" : "linear",
+	       m->degree, 32 - m->frac_bits, m->frac_bits, (unsigned long)m->crc32);
+}
+
+
+// Benchmark started from the console (benchmark, digits, stream)
+static int (*bench_step)(void);
+
+// Hand a started benchmark to bench_task(), which prompts when it is done
+static int bench_begin(int err, int (*step)(void))
+{
+	if(err != 0) return 0;
+	bench_step = step;
+	return 1;
+}
+
+// One engine (stream: one chunk) per call, so ingest, dispatch, egress and
+// the log drain run between them
+static int bench_task(void *ctx)
+{
+	if(bench_step == NULL) return 0;
+	if(bench_step() == 0) {
+		bench_step = NULL;
+		prompt();
+	}
+	return 1;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Boot                                                                  */
+/*-----------------------------------------------------------------------*/
+
+static uint64_t boot_main_cycles, boot_infer_cycles;
+static int32_t boot_result;
+
+// Load the default diabetes model and run one prediction, so the service
+// answers from the start and the power-on latency covers a real inference
+static void boot_first_inference(void)
+{
+#ifdef CSR_INFERENCE_ACCEL_BASE
+	inference_accel_init();
+	inference_accel_set_params(DIABETES_WEIGHT, DIABETES_BIAS);
+	boot_result = inference_accel_compute(0.03);
+#else
+	boot_result = fx_linear1(FX_CONST(0.03, 16), DIABETES_WEIGHT_Q16, DIABETES_BIAS_Q16, 16);
+#endif
+	boot_infer_cycles = uptime_cycles();
+}
+
+static void boot_report(void)
+{
+	const uint32_t cycles_per_us = CONFIG_CLOCK_FREQUENCY / 1000000;
+
+	if(boot_infer_cycles == 0) {
+		printf("Boot timing needs the timer uptime counter (--timer-uptime)\n");
+		return;
+	}
+	// Counted from the end of FPGA configuration (SoC reset), BIOS and firmware copy included
+	printf("Boot: main() at %lu us, first inference (%ld) at %lu us after reset\n",
+		(unsigned long)(boot_main_cycles / cycles_per_us), (long)boot_result,
+		(unsigned long)(boot_infer_cycles / cycles_per_us));
+}
+
+
 /*-----------------------------------------------------------------------*/
 /* Console service / Main                                                */
 /*-----------------------------------------------------------------------*/
 
-static void console_service(void)
+static int console_service(void)
 {
 	char *str;
 	char *token;
 
 	str = readstr();
-	if(str == NULL) return;
+	if(str == NULL) return 0;
 	token = get_token(&str);
 	if(strcmp(token, "help") == 0)
     {
@@ -290,25 +641,96 @@ static void console_service(void)
     } 
     else if(strcmp(token, "benchmark") == 0)
     {
-        benchmark();
+        if(bench_begin(benchmark_start(), benchmark_step)) return 1;
+    }
+    else if(strcmp(token, "digits") == 0)
+    {
+        if(bench_begin(digits_benchmark_start(), digits_benchmark_step)) return 1;
+    }
+    else if(strcmp(token, "flash") == 0)
+    {
+        flash_data_list();
+    }
+    else if(strcmp(token, "stream") == 0)
+    {
+        if(bench_begin(flash_benchmark_start(get_token(&str)), flash_benchmark_step)) return 1;
+    }
+    else if(strcmp(token, "load-model") == 0)
+    {
+        load_model_cmd();
+    }
+    else if(strcmp(token, "binary") == 0)
+    {
+        printf("Binary protocol mode, send an EXIT frame to leave\n");
+        uart_proto_start();
+        return 1;
+    }
+    else if(strcmp(token, "tasks") == 0)
+    {
+        sched_report();
+    }
+    else if(strcmp(token, "boot") == 0)
+    {
+        boot_report();
     }
 	prompt();
+	return 1;
+}
+
+// The console stays quiet while the binary protocol owns the UART and
+// while a benchmark runs (input waits in the UART ring)
+static int console_task(void *ctx)
+{
+	static int binary;
+
+	if(bench_step != NULL) return 0;
+
+	if(uart_proto_active()) {
+		binary = 1;
+		return 0;
+	}
+	if(binary) {
+		binary = 0;
+		printf("\nBinary protocol mode done, %lu bytes dropped\n", (unsigned long)uart_ring_rx_dropped());
+		prompt();
+		return 1;
+	}
+
+	return console_service();
 }
 
 int main(void)
 {
+	boot_main_cycles = uptime_cycles();
 #ifdef CONFIG_CPU_HAS_INTERRUPT
 	irq_setmask(0);
 	irq_setie(1);
 #endif
+	main_ram_bss_init();
 	uart_init();
-
+	uart_ring_init();
+
+	// UART ingest, accelerator dispatch and result egress run between
+	// console polls, so batches from the host never wait on the console
+	sched_add("console", console_task, NULL);
+	sched_add("bench", bench_task, NULL);
+	sched_add("ingest", uart_proto_ingest_task, NULL);
+	sched_add("dispatch", uart_proto_dispatch_task, NULL);
+	sched_add("egress", uart_proto_egress_task, NULL);
+	sched_add("log", dlog_task, NULL);
+
+	boot_first_inference();
+#ifdef BOOT_BINARY
+	// Production: straight into the inference service, EXIT frame for the console
+	printf("Binary protocol mode, send an EXIT frame to leave\n");
+	uart_proto_start();
+#else
 	help();
+	boot_report();
 	prompt();
+#endif
 
-	while(1) {
-		console_service();
-	}
+	sched_loop();
 
 	return 0;
 }
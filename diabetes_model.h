@@ -0,0 +1,14 @@
+#ifndef __DIABETES_MODEL_H
+#define __DIABETES_MODEL_H
+
+#include "fixed_kernels.h"
+
+// Diabetes regressor (lgr_microlgen.py, BMI feature): y = x * weight + bias
+#define DIABETES_WEIGHT 938.237861251353
+#define DIABETES_BIAS   152.91886182616113
+
+// Same parameters in Q16.16 (input, weight, bias and result)
+#define DIABETES_WEIGHT_Q16 FX_CONST(DIABETES_WEIGHT, 16)
+#define DIABETES_BIAS_Q16   FX_CONST(DIABETES_BIAS, 16)
+
+#endif // __DIABETES_MODEL_H
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "benchmark.h"
+#include "fixed_kernels.h"
+#include "digits_swar.h"
+#include "digits_cascade.h"
+#include "dlog.h"
+
+// Model and test set headers are written by lgr_digit.py
+#if __has_include("digits_lr_model.h") && __has_include("digits_swar_model.h") && __has_include("digits_test_data.h")
+#define DIGITS_MODEL_AVAILABLE
+#include "digits_lr_model.h"
+#include "digits_swar_model.h"
+#include "digits_test_data.h"
+#if __has_include("digits_cascade_model.h")
+#define DIGITS_CASCADE_AVAILABLE
+#include "digits_cascade_model.h"
+#endif
+#endif
+
+#define DIGITS_BENCH_ROUNDS 10
+
+#ifdef DIGITS_MODEL_AVAILABLE
+
+// Reference: int32 Q16 weights through fixed_kernels.h, pixels widened to int32
+static unsigned digits_fx_predict(const uint8_t *pixels) {
+    int32_t x[DIGITS_N_PIXELS];
+    unsigned i;
+
+    for (i = 0; i < DIGITS_N_PIXELS; i++) {
+        x[i] = pixels[i];
+    }
+
+    return fx_classify(&digits_lr_model_model, x);
+}
+
+enum {
+    DIGITS_STEP_FX,
+    DIGITS_STEP_SWAR,
+    DIGITS_STEP_CASCADE,
+    DIGITS_STEP_REPORT,
+};
+
+// Benchmark in progress, one engine per digits_benchmark_step()
+static struct {
+    int step;
+    volatile unsigned sink;
+    uint32_t fx_ticks, swar_ticks, cascade_ticks;
+    unsigned early_exits;
+} db;
+
+int digits_benchmark_start(void) {
+    db.step = DIGITS_STEP_FX;
+    db.sink = 0;
+    db.early_exits = 0;
+    db.cascade_ticks = 0;
+
+    dlog_printf("Digits benchmark: %d test images x %d rounds\n\n", DIGITS_TEST_N_SAMPLES, DIGITS_BENCH_ROUNDS);
+    return 0;
+}
+
+// Accuracy (outside the measured regions) and the summary
+static void digits_report(void) {
+    unsigned correct_fx = 0, correct_swar = 0, agree = 0;
+    uint32_t fx_ticks = db.fx_ticks, swar_ticks = db.swar_ticks;
+    unsigned i;
+#ifdef DIGITS_CASCADE_AVAILABLE
+    unsigned correct_cascade = 0;
+    uint32_t cascade_ticks = db.cascade_ticks;
+#endif
+
+    for (i = 0; i < DIGITS_TEST_N_SAMPLES; i++) {
+        unsigned fx = digits_fx_predict(digits_test_images[i]);
+        unsigned swar = digits_swar_predict(&digits_swar_model, (const uint32_t *)digits_test_images[i]);
+        correct_fx += fx == digits_test_labels[i];
+        correct_swar += swar == digits_test_labels[i];
+        agree += fx == swar;
+#ifdef DIGITS_CASCADE_AVAILABLE
+        correct_cascade += digits_cascade_predict(&digits_cascade_model,
+            (const uint32_t *)digits_test_images[i], NULL) == digits_test_labels[i];
+#endif
+    }
+
+    dlog_printf("=== Digits Results ===\n");
+    dlog_printf("Fixed-point accuracy: %u/%d\n", correct_fx, DIGITS_TEST_N_SAMPLES);
+    dlog_printf("SWAR accuracy: %u/%d\n", correct_swar, DIGITS_TEST_N_SAMPLES);
+    dlog_printf("SWAR agrees with fixed-point: %u/%d\n", agree, DIGITS_TEST_N_SAMPLES);
+    dlog_printf("Ticks per image: fixed-point %lu, SWAR %lu\n",
+                (unsigned long)(fx_ticks / (DIGITS_BENCH_ROUNDS * DIGITS_TEST_N_SAMPLES)),
+                (unsigned long)(swar_ticks / (DIGITS_BENCH_ROUNDS * DIGITS_TEST_N_SAMPLES)));
+    if (swar_ticks)
+        dlog_printf("SWAR speedup: %lu.%02lux\n", (unsigned long)(fx_ticks / swar_ticks),
+                    (unsigned long)((uint64_t)(fx_ticks % swar_ticks) * 100 / swar_ticks));
+#ifdef DIGITS_CASCADE_AVAILABLE
+    dlog_printf("Cascade accuracy: %u/%d\n", correct_cascade, DIGITS_TEST_N_SAMPLES);
+    dlog_printf("Cascade early exits: %u/%d (%lu%%)\n", db.early_exits, DIGITS_BENCH_ROUNDS * DIGITS_TEST_N_SAMPLES,
+                (unsigned long)(db.early_exits * 100UL / (DIGITS_BENCH_ROUNDS * DIGITS_TEST_N_SAMPLES)));
+    if (cascade_ticks)
+        dlog_printf("Cascade speedup over SWAR: %lu.%02lux\n", (unsigned long)(swar_ticks / cascade_ticks),
+                    (unsigned long)((uint64_t)(swar_ticks % cascade_ticks) * 100 / cascade_ticks));
+#endif
+
+    dlog_printf("\nDigits benchmark completed!\n");
+    dlog_flush();
+}
+
+int digits_benchmark_step(void) {
+    unsigned r, i;
+
+    switch (db.step++) {
+    case DIGITS_STEP_FX:
+        // Int32 fixed-point kernel (CPU)
+        dlog_printf("Running CPU fixed-point digits benchmark...\n");
+        start_stopwatch();
+
+        for (r = 0; r < DIGITS_BENCH_ROUNDS; r++) {
+            for (i = 0; i < DIGITS_TEST_N_SAMPLES; i++) {
+                db.sink += digits_fx_predict(digits_test_images[i]);
+            }
+        }
+
+        stop_stopwatch();
+        db.fx_ticks = elapsed_ticks;
+        print_elapsed_time(elapsed_ticks, "CPU Fixed-Point Digits Benchmark");
+        return 1;
+
+    case DIGITS_STEP_SWAR:
+        // SWAR kernel on packed pixels and packed int8 weights (CPU)
+        dlog_printf("Running CPU SWAR digits benchmark...\n");
+        start_stopwatch();
+
+        for (r = 0; r < DIGITS_BENCH_ROUNDS; r++) {
+            for (i = 0; i < DIGITS_TEST_N_SAMPLES; i++) {
+                db.sink += digits_swar_predict(&digits_swar_model, (const uint32_t *)digits_test_images[i]);
+            }
+        }
+
+        stop_stopwatch();
+        db.swar_ticks = elapsed_ticks;
+        print_elapsed_time(elapsed_ticks, "CPU SWAR Digits Benchmark");
+        return 1;
+
+#ifdef DIGITS_CASCADE_AVAILABLE
+    case DIGITS_STEP_CASCADE: {
+        // Early-exit cascade: stage-1 pixels, SWAR model when the margin is low (CPU)
+        int early;
+
+        dlog_printf("Running CPU cascade digits benchmark...\n");
+        start_stopwatch();
+
+        for (r = 0; r < DIGITS_BENCH_ROUNDS; r++) {
+            for (i = 0; i < DIGITS_TEST_N_SAMPLES; i++) {
+                db.sink += digits_cascade_predict(&digits_cascade_model, (const uint32_t *)digits_test_images[i], &early);
+                db.early_exits += early;
+            }
+        }
+
+        stop_stopwatch();
+        db.cascade_ticks = elapsed_ticks;
+        print_elapsed_time(elapsed_ticks, "CPU Cascade Digits Benchmark");
+        return 1;
+    }
+#endif
+
+    case DIGITS_STEP_REPORT:
+        digits_report();
+        return 0;
+
+    default:
+        // Engine not built in
+        return db.step <= DIGITS_STEP_REPORT;
+    }
+}
+
+#else
+
+int digits_benchmark_start(void) {
+    printf("Digits model not built in: run lgr_digit.py and rebuild\n");
+    return -1;
+}
+
+int digits_benchmark_step(void) {
+    return 0;
+}
+
+#endif // DIGITS_MODEL_AVAILABLE
@@ -0,0 +1,35 @@
+#include "digits_cascade.h"
+
+unsigned digits_cascade_predict(const struct digits_cascade *c, const uint32_t *image, int *early) {
+    const uint8_t *pixels = (const uint8_t *)image;
+    const int32_t *w = c->weights;
+    int32_t score, best_score = 0, second_score = 0;
+    unsigned k, j, best = 0;
+
+    // Pixels are at most 16, so 32-bit products and sums are enough
+    for (k = 0; k < c->n_classes; k++) {
+        score = c->biases[k];
+        for (j = 0; j < c->n_features; j++) {
+            score += pixels[c->pixels[j]] * w[j];
+        }
+        w += c->n_features;
+
+        if (k == 0 || score > best_score) {
+            second_score = best_score;
+            best_score = score;
+            best = k;
+        } else if (k == 1 || score > second_score) {
+            second_score = score;
+        }
+    }
+
+    if (best_score - second_score >= c->margin) {
+        if (early)
+            *early = 1;
+        return best;
+    }
+
+    if (early)
+        *early = 0;
+    return digits_swar_predict(c->full, image);
+}
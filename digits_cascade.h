@@ -0,0 +1,28 @@
+#ifndef __DIGITS_CASCADE_H
+#define __DIGITS_CASCADE_H
+
+#include <stdint.h>
+
+#include "digits_swar.h"
+
+// Early-exit cascade for the digits classifier
+//
+// Stage 1 is a small linear model on a few high-importance pixels. When the
+// gap between its two best logits reaches `margin` the sample exits there;
+// otherwise it falls through to the full 64-pixel SWAR model. Pixels,
+// weights and the threshold are picked by lgr_digit.py.
+struct digits_cascade {
+    const uint8_t *pixels;      // stage-1 pixel indices (0-63)
+    const int32_t *weights;     // n_classes x n_features, Q(w_frac_bits)
+    const int32_t *biases;      // Q(w_frac_bits)
+    uint8_t n_features;
+    uint8_t n_classes;
+    uint8_t w_frac_bits;
+    int32_t margin;             // Q(w_frac_bits) top-1 minus top-2 logit
+    const struct digits_swar_model *full;
+};
+
+// *early is set to 1 when stage 1 decided (may be NULL)
+unsigned digits_cascade_predict(const struct digits_cascade *c, const uint32_t *image, int *early);
+
+#endif // __DIGITS_CASCADE_H
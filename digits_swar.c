@@ -0,0 +1,78 @@
+#include "digits_swar.h"
+
+#define LANES_MASK 0x00ff00ffu
+
+// Unpacked pixel lanes, shared by all classes of one image
+struct digits_lanes {
+    uint32_t even[DIGITS_N_WORDS];  // p0 | p2 << 16
+    uint32_t odd[DIGITS_N_WORDS];   // p1 | p3 << 16
+    int32_t offset;                 // DIGITS_WEIGHT_OFFSET * sum(pixels)
+};
+
+static void digits_unpack(const uint32_t *image, struct digits_lanes *l) {
+    uint32_t sum = 0;
+    unsigned k;
+
+    for (k = 0; k < DIGITS_N_WORDS; k++) {
+        l->even[k] = image[k] & LANES_MASK;
+        l->odd[k] = (image[k] >> 8) & LANES_MASK;
+        sum += l->even[k] + l->odd[k];
+    }
+
+    // Both 16-bit lanes hold partial sums (at most 64 * 16 each)
+    l->offset = DIGITS_WEIGHT_OFFSET * (int32_t)((sum & 0xffff) + (sum >> 16));
+}
+
+// Offset-weight dot product of one class, 8 products per lane flush
+static inline int32_t digits_dot(const struct digits_lanes *l, const uint32_t *w) {
+    uint32_t acc;
+    int32_t dot = 0;
+    unsigned k, j;
+
+    for (k = 0; k < DIGITS_N_WORDS; k += 4) {
+        acc = 0;
+        for (j = k; j < k + 4; j++) {
+            acc += l->even[j] * (w[j] & LANES_MASK);
+            acc += l->odd[j] * ((w[j] >> 8) & LANES_MASK);
+        }
+        dot += acc >> 16;
+    }
+
+    return dot - l->offset;
+}
+
+void digits_swar_scores(const struct digits_swar_model *m, const uint32_t *image, int32_t *scores) {
+    struct digits_lanes l;
+    unsigned c;
+
+    digits_unpack(image, &l);
+    for (c = 0; c < m->n_classes; c++) {
+        scores[c] = digits_dot(&l, &m->weights[c * DIGITS_N_WORDS]) + m->biases[c];
+    }
+}
+
+unsigned digits_swar_predict(const struct digits_swar_model *m, const uint32_t *image) {
+    struct digits_lanes l;
+    int32_t score, best_score = 0;
+    unsigned c, best = 0;
+
+    digits_unpack(image, &l);
+    for (c = 0; c < m->n_classes; c++) {
+        score = digits_dot(&l, &m->weights[c * DIGITS_N_WORDS]) + m->biases[c];
+        if (c == 0 || score > best_score) {
+            best_score = score;
+            best = c;
+        }
+    }
+
+    return best;
+}
+
+void digits_swar_predict_batch(const struct digits_swar_model *m, const uint32_t *images, uint8_t *labels, unsigned n) {
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        labels[i] = (uint8_t)digits_swar_predict(m, images);
+        images += DIGITS_N_WORDS;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef __DIGITS_SWAR_H
+#define __DIGITS_SWAR_H
+
+#include <stdint.h>
+
+// SWAR (SIMD within a register) kernel for the 8x8 digits classifier
+//
+// Images are 64 uint8 pixels (0-16), i.e. 16 words with pixel 4k+j in byte j
+// of word k. Weights are int8 offset by +128 (uint8), also four per word but
+// with halfwords swapped: bytes [w2, w3, w0, w1] for pixels 4k..4k+3.
+//
+// Masking a word with 0x00ff00ff gives two 16-bit lanes. Multiplying the
+// pixel lanes (p0 | p2 << 16) by the weight lanes (w2 | w0 << 16) puts
+// p0*w0 + p2*w2 in bits 16..31 of the 32-bit product, so one mul does two
+// multiply-accumulates. Products are at most 16*255, so eight of them can be
+// summed before the upper lane would overflow.
+//
+// The +128 weight offset is removed once per image: 128 * sum(pixels).
+
+#define DIGITS_N_PIXELS 64
+#define DIGITS_N_WORDS  (DIGITS_N_PIXELS / 4)
+#define DIGITS_MAX_CLASSES 16
+
+#define DIGITS_WEIGHT_OFFSET 128
+
+struct digits_swar_model {
+    const uint32_t *weights;    // n_classes x DIGITS_N_WORDS packed words
+    const int32_t *biases;      // Q(w_frac_bits), one per class
+    uint8_t n_classes;
+    uint8_t w_frac_bits;        // scores are Q(w_frac_bits) logits
+};
+
+void digits_swar_scores(const struct digits_swar_model *m, const uint32_t *image, int32_t *scores);
+unsigned digits_swar_predict(const struct digits_swar_model *m, const uint32_t *image);
+void digits_swar_predict_batch(const struct digits_swar_model *m, const uint32_t *images, uint8_t *labels, unsigned n);
+
+#endif // __DIGITS_SWAR_H
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "uart_ring.h"
+#include "uart_proto.h"
+#include "dlog.h"
+
+#define DLOG_MASK (DLOG_SIZE - 1)
+
+// Bytes handed to the UART per idle task call
+#define DLOG_TASK_BUDGET 64
+
+static char ring[DLOG_SIZE];
+static unsigned produce;
+static unsigned consume;
+static int measuring;
+static uint32_t dropped;
+
+unsigned dlog_pending(void) {
+    return (produce - consume) & DLOG_MASK;
+}
+
+static unsigned dlog_free(void) {
+    return DLOG_SIZE - 1 - dlog_pending();
+}
+
+void dlog_set_measuring(int m) {
+    measuring = m;
+}
+
+void dlog_printf(const char *fmt, ...) {
+    char line[DLOG_LINE_MAX];
+    va_list args;
+    int len, i;
+
+    va_start(args, fmt);
+    len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (len <= 0)
+        return;
+    if (len >= (int)sizeof(line))
+        len = sizeof(line) - 1;
+
+    if (dlog_free() < (unsigned)len) {
+        if (measuring) {
+            dropped += len;
+            return;
+        }
+        while (dlog_free() < (unsigned)len) {
+            dlog_drain(DLOG_SIZE);
+        }
+    }
+
+    for (i = 0; i < len; i++) {
+        ring[produce] = line[i];
+        produce = (produce + 1) & DLOG_MASK;
+    }
+}
+
+unsigned dlog_drain(unsigned max) {
+    unsigned total = 0, n, sent;
+
+    while (total < max && consume != produce) {
+        // Contiguous run up to the write position or the end of the ring
+        n = (produce > consume ? produce : DLOG_SIZE) - consume;
+        if (n > max - total)
+            n = max - total;
+        sent = uart_ring_write_nonblock((const uint8_t *)&ring[consume], n);
+        consume = (consume + sent) & DLOG_MASK;
+        total += sent;
+        if (sent < n)
+            break;
+    }
+
+    return total;
+}
+
+void dlog_flush(void) {
+    uint32_t lost;
+
+    while (dlog_pending()) {
+        dlog_drain(DLOG_SIZE);
+    }
+    if (dropped) {
+        lost = dropped;
+        dropped = 0;
+        dlog_printf("(log: %lu bytes dropped while measuring)\n", (unsigned long)lost);
+        while (dlog_pending()) {
+            dlog_drain(DLOG_SIZE);
+        }
+    }
+    // printf() output goes through libbase's queue, let ours go out first
+    uart_ring_flush();
+}
+
+int dlog_task(void *ctx) {
+    if (uart_proto_active() || !dlog_pending())
+        return 0;
+    return dlog_drain(DLOG_TASK_BUDGET) != 0;
+}
@@ -0,0 +1,37 @@
+#ifndef __DLOG_H
+#define __DLOG_H
+
+#include <stdint.h>
+
+// Deferred console log
+//
+// printf() waits on the UART once libbase's 128 byte queue is full, so a
+// report printed between measurements (or a log line inside one) costs
+// ~87 us per byte at 115200 baud. dlog_printf() only formats into a RAM
+// ring; the ring is drained after the benchmark (dlog_flush) or by the idle
+// scheduler task. Inside a stopwatch region a full ring drops the message
+// and counts it, outside one it is flushed first, so reports never get lost.
+// start_stopwatch() waits for the UART to finish sending such a flush, so
+// no transmit interrupt lands inside the measured region.
+
+// Power-of-two size, in .bss (SRAM) so logging does not touch main_ram
+#ifndef DLOG_SIZE
+#define DLOG_SIZE 2048
+#endif
+#define DLOG_LINE_MAX 128
+
+void dlog_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Set by start_stopwatch()/stop_stopwatch(): drop instead of blocking
+void dlog_set_measuring(int measuring);
+
+unsigned dlog_pending(void);
+// Queue up to max bytes on the UART without blocking, returns the byte count
+unsigned dlog_drain(unsigned max);
+// Block until everything is sent, reporting dropped bytes if any
+void dlog_flush(void);
+
+// Idle scheduler task (sched.h), stays quiet while binary mode owns the UART
+int dlog_task(void *ctx);
+
+#endif // __DLOG_H
@@ -0,0 +1,457 @@
+#!/usr/bin/env python3
+
+# Fixed-point C model exporter
+#
+# Replaces micromlgen's float output for the FPU-less CPU: takes a trained
+# sklearn LinearRegression or LogisticRegression and writes a C header with
+# integer weights in power-of-two Q formats and an integer-only predict
+# function. Optionally writes the accelerator parameter blob as well.
+# Single-feature PolynomialFeatures + LinearRegression pipelines are exported
+# as Horner coefficients for the accelerator's polynomial mode.
+
+import json
+import struct
+import zlib
+
+import numpy as np
+
+INT32_MIN = -(1 << 31)
+INT32_MAX = (1 << 31) - 1
+
+# Accelerator parameter blob (little endian), used by the firmware model loader:
+#   u32 magic      ACCEL_BLOB_MAGIC
+#   u8  version    ACCEL_BLOB_VERSION
+#   u8  kind       ACCEL_KIND_*
+#   u8  frac_bits  Q format of input, coefficients and result
+#   u8  n_coeffs   number of coefficients that follow
+#   i32 coeffs[]   ascending powers of x: c0 (bias), c1 (weight), ...
+#   u32 crc32      CRC-32 of all preceding bytes
+ACCEL_BLOB_MAGIC   = 0x444D4149 # "IAMD"
+ACCEL_BLOB_VERSION = 1
+ACCEL_KIND_LINEAR  = 0
+ACCEL_KIND_POLY    = 1
+
+
+def quantize(values, frac_bits):
+    """Round real values to Q(frac_bits) integers, checking the int32 range."""
+    q = np.round(np.asarray(values, dtype=np.float64) * (1 << frac_bits)).astype(np.int64)
+    if q.size and (q.min() < INT32_MIN or q.max() > INT32_MAX):
+        raise ValueError("Q{} format overflows int32 (max |v| = {})".format(
+            frac_bits, np.abs(np.asarray(values)).max()))
+    return q
+
+
+def model_params(model):
+    """Return (weights[n_rows][n_features], biases[n_rows], is_classifier)."""
+    coef = np.atleast_2d(np.asarray(model.coef_, dtype=np.float64))
+    intercept = np.atleast_1d(np.asarray(model.intercept_, dtype=np.float64))
+    if intercept.size == 1 and coef.shape[0] > 1:
+        intercept = np.repeat(intercept, coef.shape[0])
+    is_classifier = hasattr(model, "classes_")
+    return coef, intercept, is_classifier
+
+
+def _c_array(values, per_line=8, indent="    "):
+    values = [str(int(v)) for v in values]
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append(indent + ", ".join(values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def accel_blob(coeffs_q, frac_bits, kind=ACCEL_KIND_LINEAR):
+    """Pack accelerator coefficients (ascending powers of x, already quantized)."""
+    body = struct.pack("<IBBBB", ACCEL_BLOB_MAGIC, ACCEL_BLOB_VERSION, kind, frac_bits, len(coeffs_q))
+    body += struct.pack("<{}i".format(len(coeffs_q)), *[int(c) for c in coeffs_q])
+    return body + struct.pack("<I", zlib.crc32(body) & 0xffffffff)
+
+
+def c_int_type(bits):
+    """Narrowest C integer type holding signed `bits`-bit values."""
+    for width in [8, 16, 32]:
+        if bits <= width:
+            return "int{}_t".format(width)
+    raise ValueError("no C type for {}-bit values".format(bits))
+
+
+def generate_header(model, name, in_frac_bits=16, w_frac_bits=16, out_frac_bits=16,
+    act_bits=32, weight_bits=32, classmap=None, with_accel_blob=False, accel_frac_bits=16):
+    """Return the C header text for `model`.
+
+    Weights are stored and inputs taken in the narrowest C types for weight_bits
+    and act_bits; biases and scores stay int32_t."""
+    weights, biases, is_classifier = model_params(model)
+    n_rows, n_features = weights.shape
+    shift = in_frac_bits + w_frac_bits - out_frac_bits
+    if shift < 0:
+        raise ValueError("output format finer than input * weight")
+
+    w_q = quantize(weights.ravel(), w_frac_bits)
+    b_q = quantize(biases, out_frac_bits)
+    if w_q.size and max(-w_q.min() - 1, w_q.max()) >= (1 << (weight_bits - 1)):
+        raise ValueError("Q{} weights overflow {} bits".format(w_frac_bits, weight_bits))
+    w_type = c_int_type(weight_bits)
+    x_type = c_int_type(act_bits)
+    upper = name.upper()
+    guard = "__{}_H".format(upper)
+    round_term = "(((int64_t)1 << {}) >> 1)".format(shift) if shift else "0"
+
+    out = []
+    out.append("// Generated by fixed_codegen.py from {} - do not edit".format(type(model).__name__))
+    out.append("#ifndef {}".format(guard))
+    out.append("#define {}".format(guard))
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("// x is Q{0}.{1}, weights are Q{2}.{3}, biases and scores are Q{4}.{5}".format(
+        act_bits - in_frac_bits, in_frac_bits, weight_bits - w_frac_bits, w_frac_bits, 32 - out_frac_bits, out_frac_bits))
+    out.append("#define {}_N_FEATURES    {}".format(upper, n_features))
+    out.append("#define {}_N_ROWS        {}".format(upper, n_rows))
+    if is_classifier:
+        out.append("#define {}_N_CLASSES     {}".format(upper, len(model.classes_)))
+    out.append("#define {}_IN_FRAC_BITS  {}".format(upper, in_frac_bits))
+    out.append("#define {}_W_FRAC_BITS   {}".format(upper, w_frac_bits))
+    out.append("#define {}_OUT_FRAC_BITS {}".format(upper, out_frac_bits))
+    out.append("#define {}_SHIFT         {}".format(upper, shift))
+    out.append("")
+    out.append("typedef {} {}_input_t;".format(x_type, name))
+    out.append("")
+    out.append("static const {} {}_weights[{}] = {{".format(w_type, name, n_rows * n_features))
+    out.append(_c_array(w_q))
+    out.append("};")
+    out.append("")
+    out.append("static const int32_t {}_biases[{}] = {{".format(name, n_rows))
+    out.append(_c_array(b_q))
+    out.append("};")
+    out.append("")
+    if is_classifier and classmap is not None:
+        out.append("static const char *const {}_labels[{}] = {{".format(name, len(model.classes_)))
+        out.append("    " + ", ".join('"{}"'.format(classmap.get(c, c)) for c in range(len(model.classes_))) + ",")
+        out.append("};")
+        out.append("")
+
+    out.append("// Score of row k (Q{}.{})".format(32 - out_frac_bits, out_frac_bits))
+    out.append("static inline int32_t {0}_score(const {0}_input_t *x, unsigned k) {{".format(name))
+    out.append("    const {} *w = &{}_weights[k * {}];".format(w_type, name, n_features))
+    out.append("    int64_t acc = {};".format(round_term))
+    out.append("    unsigned i;")
+    out.append("")
+    out.append("    for (i = 0; i < {}; i++) {{".format(n_features))
+    out.append("        acc += (int64_t)x[i] * w[i];")
+    out.append("    }")
+    out.append("")
+    out.append("    return (int32_t)(acc >> {}) + {}_biases[k];".format(shift, name))
+    out.append("}")
+    out.append("")
+
+    if not is_classifier:
+        out.append("// Regression output (Q{}.{})".format(32 - out_frac_bits, out_frac_bits))
+        out.append("static inline int32_t {0}_predict(const {0}_input_t *x) {{".format(name))
+        out.append("    return {}_score(x, 0);".format(name))
+        out.append("}")
+    elif n_rows == 1:
+        out.append("// Binary classifier: class 1 when the logit is positive")
+        out.append("static inline int {0}_predict(const {0}_input_t *x) {{".format(name))
+        out.append("    return {}_score(x, 0) > 0;".format(name))
+        out.append("}")
+    else:
+        out.append("// Class with the highest logit (no sigmoid/softmax needed)")
+        out.append("static inline int {0}_predict(const {0}_input_t *x) {{".format(name))
+        out.append("    int32_t score, best_score = {}_score(x, 0);".format(name))
+        out.append("    unsigned k, best = 0;")
+        out.append("")
+        out.append("    for (k = 1; k < {}; k++) {{".format(n_rows))
+        out.append("        score = {}_score(x, k);".format(name))
+        out.append("        if (score > best_score) {")
+        out.append("            best_score = score;")
+        out.append("            best = k;")
+        out.append("        }")
+        out.append("    }")
+        out.append("")
+        out.append("    return best;")
+        out.append("}")
+    out.append("")
+
+    # Same parameters as fixed_kernels.h descriptors when that header is in use
+    # (binary classifiers have a single logit row, which fx_classify() does not cover,
+    # and the descriptors take int32 weights and inputs)
+    if (not is_classifier or n_rows > 1) and w_type == x_type == "int32_t":
+        out.append("#ifdef __FIXED_KERNELS_H")
+        if is_classifier:
+            out.append("static const struct fx_linear_classifier {}_model = {{".format(name))
+            out.append("    {0}_weights, {0}_biases, {1}, {2}, {3}".format(name, n_features, n_rows, shift))
+        else:
+            out.append("static const struct fx_linear_model {}_model = {{".format(name))
+            out.append("    {0}_weights, {1}, {2}, {3}".format(name, int(b_q[0]), n_features, shift))
+        out.append("};")
+        out.append("#endif")
+        out.append("")
+
+    if with_accel_blob:
+        blob = accel_blob(model_accel_coeffs(model, accel_frac_bits), accel_frac_bits)
+        out.append("// Accelerator parameter blob (see fixed_codegen.py for the layout)")
+        out.append("static const uint8_t {}_accel_blob[{}] = {{".format(name, len(blob)))
+        out.append(_c_array(blob, per_line=12))
+        out.append("};")
+        out.append("")
+
+    out.append("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+
+def model_accel_coeffs(model, frac_bits):
+    """Quantized accelerator coefficients [bias, weight] of a one-feature regressor."""
+    weights, biases, is_classifier = model_params(model)
+    if is_classifier or weights.shape != (1, 1):
+        raise ValueError("accelerator only supports single-feature regression models")
+    return quantize([biases[0], weights[0, 0]], frac_bits)
+
+
+def polynomial_params(model):
+    """Real coefficients c0..cN (ascending powers of x) of a one-feature
+    PolynomialFeatures + LinearRegression pipeline."""
+    steps = [step for _, step in model.steps] if hasattr(model, "steps") else [model]
+    if len(steps) != 2 or not hasattr(steps[0], "powers_") or not hasattr(steps[1], "coef_"):
+        raise ValueError("expected a PolynomialFeatures + LinearRegression pipeline")
+    poly, reg = steps
+    powers = np.asarray(poly.powers_)
+    if powers.shape[1] != 1:
+        raise ValueError("polynomial export only supports single-feature models")
+    coef = np.ravel(reg.coef_)
+    coeffs = np.zeros(int(powers.max()) + 1)
+    for p, c in zip(powers[:, 0], coef):
+        coeffs[p] += c
+    coeffs[0] += float(np.ravel(reg.intercept_)[0])
+    return coeffs
+
+
+def poly_max_frac_bits(coeffs, data_width=32):
+    """Largest fraction bits that keep every coefficient within data_width bits."""
+    max_c = float(np.abs(coeffs).max())
+    if max_c == 0:
+        return data_width - 1
+    return min(data_width - 1, int(np.floor(np.log2(((1 << (data_width - 1)) - 1) / max_c))))
+
+
+def horner(coeffs_q, x_q, frac_bits, data_width=32):
+    """Bit-exact model of the accelerator's Horner pipeline (floor shifts, each
+    stage wrapped to data_width bits)."""
+    half = 1 << (data_width - 1)
+    x = (int(x_q) + half) % (2 * half) - half
+    acc = (int(coeffs_q[-1]) + half) % (2 * half) - half
+    for c in reversed(coeffs_q[:-1]):
+        acc = ((acc * x) >> frac_bits) + int(c)
+        acc = (acc + half) % (2 * half) - half
+    return acc
+
+
+def generate_poly_header(model, name, frac_bits=16):
+    """C header for a polynomial pipeline: Horner coefficients, an integer predict
+    function matching the accelerator and the accelerator parameter blob."""
+    coeffs = polynomial_params(model)
+    if poly_max_frac_bits(coeffs) < frac_bits:
+        raise ValueError("Q{} coefficients overflow int32, use at most {} fraction bits".format(
+            frac_bits, poly_max_frac_bits(coeffs)))
+    c_q = quantize(coeffs, frac_bits)
+    degree = len(c_q) - 1
+    upper = name.upper()
+    guard = "__{}_H".format(upper)
+    blob = accel_blob(c_q, frac_bits, ACCEL_KIND_POLY)
+
+    out = []
+    out.append("// Generated by fixed_codegen.py from a degree {} polynomial - do not edit".format(degree))
+    out.append("#ifndef {}".format(guard))
+    out.append("#define {}".format(guard))
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("// x, coefficients and result are Q{}.{}".format(32 - frac_bits, frac_bits))
+    out.append("#define {}_DEGREE    {}".format(upper, degree))
+    out.append("#define {}_FRAC_BITS {}".format(upper, frac_bits))
+    out.append("")
+    out.append("// Ascending powers of x: c0 .. c{}".format(degree))
+    out.append("static const int32_t {}_coeffs[{}] = {{".format(name, degree + 1))
+    out.append(_c_array(c_q))
+    out.append("};")
+    out.append("")
+    out.append("// Horner evaluation, same truncating steps as the accelerator pipeline")
+    out.append("static inline int32_t {}_predict(int32_t x) {{".format(name))
+    out.append("    int32_t acc = {}_coeffs[{}];".format(name, degree))
+    out.append("    int k;")
+    out.append("")
+    out.append("    for (k = {}; k >= 0; k--) {{".format(degree - 1))
+    out.append("        acc = (int32_t)(((int64_t)acc * x) >> {}) + {}_coeffs[k];".format(frac_bits, name))
+    out.append("    }")
+    out.append("")
+    out.append("    return acc;")
+    out.append("}")
+    out.append("")
+    out.append("// Accelerator parameter blob (see fixed_codegen.py for the layout)")
+    out.append("static const uint8_t {}_accel_blob[{}] = {{".format(name, len(blob)))
+    out.append(_c_array(blob, per_line=12))
+    out.append("};")
+    out.append("")
+    out.append("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+
+def swar_frac_bits(weights):
+    """Largest fraction bits that keep every weight within int8."""
+    max_w = float(np.abs(weights).max())
+    return max(0, int(np.floor(np.log2(127.0 / max_w)))) if max_w > 0 else 7
+
+
+def generate_swar_header(model, name, w_frac_bits=None):
+    """Header for digits_swar.h: int8 weights offset to uint8, packed [w2, w3, w0, w1] per word."""
+    weights, biases, is_classifier = model_params(model)
+    n_rows, n_features = weights.shape
+    if not is_classifier or n_features % 4 or n_rows < 2:
+        raise ValueError("SWAR kernel needs a multiclass classifier with a multiple of 4 features")
+    if w_frac_bits is None:
+        w_frac_bits = swar_frac_bits(weights)
+    w_q = np.clip(quantize(weights, w_frac_bits), -128, 127) + 128
+    b_q = quantize(biases, w_frac_bits)
+
+    words = []
+    for row in w_q:
+        for k in range(0, n_features, 4):
+            w0, w1, w2, w3 = [int(v) for v in row[k:k + 4]]
+            words.append(w2 | (w3 << 8) | (w0 << 16) | (w1 << 24))
+
+    upper = name.upper()
+    guard = "__{}_H".format(upper)
+    out = []
+    out.append("// Generated by fixed_codegen.py from {} - do not edit".format(type(model).__name__))
+    out.append("#ifndef {}".format(guard))
+    out.append("#define {}".format(guard))
+    out.append("")
+    out.append("#include \"digits_swar.h\"")
+    out.append("")
+    out.append("// int8 weights Q0.{0} (+{1} offset), biases and logits Q.{0}".format(w_frac_bits, 128))
+    out.append("#define {}_N_CLASSES   {}".format(upper, n_rows))
+    out.append("#define {}_W_FRAC_BITS {}".format(upper, w_frac_bits))
+    out.append("")
+    out.append("static const uint32_t {}_weights[{}] = {{".format(name, len(words)))
+    for i in range(0, len(words), 4):
+        out.append("    " + ", ".join("0x{:08x}".format(w) for w in words[i:i + 4]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("static const int32_t {}_biases[{}] = {{".format(name, n_rows))
+    out.append(_c_array(b_q))
+    out.append("};")
+    out.append("")
+    out.append("static const struct digits_swar_model {} = {{".format(name))
+    out.append("    {0}_weights, {0}_biases, {1}, {2}".format(name, n_rows, w_frac_bits))
+    out.append("};")
+    out.append("")
+    out.append("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+
+def generate_cascade_header(name, pixels, weights_q, biases_q, frac_bits, margin, swar_name="digits_swar_model"):
+    """Header for digits_cascade.h: stage-1 pixels and Q.frac_bits weights/biases (already
+    quantized), exiting early when the top-2 logit margin reaches `margin`, else `swar_name`."""
+    weights_q = np.asarray(weights_q)
+    biases_q = np.asarray(biases_q)
+    if weights_q.shape != (len(biases_q), len(pixels)):
+        raise ValueError("stage-1 weights must be n_classes x n_pixels")
+    upper = name.upper()
+    guard = "__{}_H".format(upper)
+    out = []
+    out.append("// Generated by fixed_codegen.py - do not edit")
+    out.append("#ifndef {}".format(guard))
+    out.append("#define {}".format(guard))
+    out.append("")
+    out.append("#include \"digits_cascade.h\"")
+    out.append("#include \"{}.h\"".format(swar_name))
+    out.append("")
+    out.append("static const uint8_t {}_pixels[{}] = {{".format(name, len(pixels)))
+    out.append(_c_array(pixels, per_line=16))
+    out.append("};")
+    out.append("")
+    out.append("static const int32_t {}_weights[{}] = {{".format(name, weights_q.size))
+    out.append(_c_array(weights_q.ravel()))
+    out.append("};")
+    out.append("")
+    out.append("static const int32_t {}_biases[{}] = {{".format(name, biases_q.size))
+    out.append(_c_array(biases_q))
+    out.append("};")
+    out.append("")
+    out.append("static const struct digits_cascade {} = {{".format(name))
+    out.append("    {0}_pixels, {0}_weights, {0}_biases,".format(name))
+    out.append("    {}, {}, {}, {}, &{}".format(len(pixels), len(biases_q), frac_bits, margin, swar_name))
+    out.append("};")
+    out.append("")
+    out.append("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+
+def generate_dataset_header(X, y, name):
+    """Test images as packed uint8 pixels (word aligned) plus labels."""
+    X = np.asarray(X).astype(np.int64)
+    if X.min() < 0 or X.max() > 255:
+        raise ValueError("pixels must fit in uint8")
+    upper = name.upper()
+    guard = "__{}_H".format(upper)
+    out = []
+    out.append("// Generated by fixed_codegen.py - do not edit")
+    out.append("#ifndef {}".format(guard))
+    out.append("#define {}".format(guard))
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("#define {}_N_SAMPLES  {}".format(upper, X.shape[0]))
+    out.append("#define {}_N_FEATURES {}".format(upper, X.shape[1]))
+    out.append("")
+    out.append("static const uint8_t {}_images[{}][{}] __attribute__((aligned(4))) = {{".format(
+        name, X.shape[0], X.shape[1]))
+    for row in X:
+        out.append("    {" + ", ".join(str(int(v)) for v in row) + "},")
+    out.append("};")
+    out.append("")
+    out.append("static const uint8_t {}_labels[{}] = {{".format(name, len(y)))
+    out.append(_c_array(y, per_line=16))
+    out.append("};")
+    out.append("")
+    out.append("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+
+def format_kwargs(fmt):
+    """Exporter arguments from a quant_calibrate.py format dict."""
+    kwargs = {}
+    if "cpu" in fmt:
+        for key in ["act_bits", "in_frac_bits", "weight_bits", "w_frac_bits", "out_frac_bits"]:
+            kwargs[key] = fmt["cpu"][key]
+    if "accel" in fmt:
+        kwargs["accel_frac_bits"] = fmt["accel"]["frac_bits"]
+    return kwargs
+
+
+def load_format(path):
+    """Exporter arguments from a quant_calibrate.py format file."""
+    with open(path) as f:
+        return format_kwargs(json.load(f))
+
+
+def export(model, name, path=None, blob_path=None, **kwargs):
+    """Write the header (and optionally the accelerator blob) for `model`."""
+    path = path or "{}.h".format(name)
+    with open(path, "w") as f:
+        f.write(generate_header(model, name, with_accel_blob=blob_path is not None, **kwargs))
+    if blob_path is not None:
+        frac_bits = kwargs.get("accel_frac_bits", 16)
+        with open(blob_path, "wb") as f:
+            f.write(accel_blob(model_accel_coeffs(model, frac_bits), frac_bits))
+    return path
+
+
+def export_polynomial(model, name, path=None, blob_path=None, frac_bits=16):
+    """Write the header (and optionally the accelerator blob) for a polynomial pipeline."""
+    path = path or "{}.h".format(name)
+    with open(path, "w") as f:
+        f.write(generate_poly_header(model, name, frac_bits))
+    if blob_path is not None:
+        with open(blob_path, "wb") as f:
+            f.write(accel_blob(quantize(polynomial_params(model), frac_bits), frac_bits, ACCEL_KIND_POLY))
+    return path
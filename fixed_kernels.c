@@ -0,0 +1,83 @@
+#include "fixed_kernels.h"
+
+// Dot product accumulated in 64 bits (mul/mulh on RV32IM), one final shift
+int32_t fx_dot(const int32_t *a, const int32_t *b, unsigned n, unsigned shift) {
+    int64_t acc = 0;
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        acc += (int64_t)a[i] * b[i];
+    }
+
+    return fx_shr_round(acc, shift);
+}
+
+int32_t fx_linear_predict(const struct fx_linear_model *m, const int32_t *x) {
+    return fx_dot(x, m->weights, m->n_features, m->shift) + m->bias;
+}
+
+// x holds n samples of n_features each (row-major), y receives n results
+void fx_linear_predict_batch(const struct fx_linear_model *m, const int32_t *x, int32_t *y, unsigned n) {
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        y[i] = fx_dot(x, m->weights, m->n_features, m->shift) + m->bias;
+        x += m->n_features;
+    }
+}
+
+void fx_linear1_batch(int32_t weight, int32_t bias, unsigned shift, const int32_t *x, int32_t *y, unsigned n) {
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        y[i] = fx_linear1(x[i], weight, bias, shift);
+    }
+}
+
+unsigned fx_argmax(const int32_t *v, unsigned n) {
+    unsigned i, best = 0;
+
+    for (i = 1; i < n; i++) {
+        if (v[i] > v[best])
+            best = i;
+    }
+
+    return best;
+}
+
+void fx_classifier_scores(const struct fx_linear_classifier *c, const int32_t *x, int32_t *scores) {
+    const int32_t *w = c->weights;
+    unsigned k;
+
+    for (k = 0; k < c->n_classes; k++) {
+        scores[k] = fx_dot(x, w, c->n_features, c->shift) + c->biases[k];
+        w += c->n_features;
+    }
+}
+
+// Argmax computed on the fly, so no scores buffer is needed
+unsigned fx_classify(const struct fx_linear_classifier *c, const int32_t *x) {
+    const int32_t *w = c->weights;
+    int32_t score, best_score = 0;
+    unsigned k, best = 0;
+
+    for (k = 0; k < c->n_classes; k++) {
+        score = fx_dot(x, w, c->n_features, c->shift) + c->biases[k];
+        if (k == 0 || score > best_score) {
+            best_score = score;
+            best = k;
+        }
+        w += c->n_features;
+    }
+
+    return best;
+}
+
+void fx_classify_batch(const struct fx_linear_classifier *c, const int32_t *x, uint8_t *labels, unsigned n) {
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        labels[i] = (uint8_t)fx_classify(c, x);
+        x += c->n_features;
+    }
+}
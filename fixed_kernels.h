@@ -0,0 +1,75 @@
+#ifndef __FIXED_KERNELS_H
+#define __FIXED_KERNELS_H
+
+#include <stdint.h>
+
+// Fixed-point software kernels (CPU baseline / fallback without accelerator)
+//
+// Values use power-of-two Q formats: a real value v is stored as
+// round(v * 2^frac_bits). Rescaling is always a shift, so the hot loops
+// never divide and never touch soft-float.
+
+#define FX_Q16_FRAC_BITS 16
+
+// Compile-time conversion of a real literal to Q(frac) (constants only)
+#define FX_CONST(x, frac) ((int32_t)((x) * (double)(1L << (frac)) + ((x) >= 0 ? 0.5 : -0.5)))
+
+// Batch size used by the benchmark batch entry points
+#define FX_BATCH_SIZE 64
+
+// Linear model: y = sum(x[i] * weights[i]) + bias
+// x is Q(in_frac), weights are Q(w_frac), bias and y are Q(out_frac),
+// and shift = in_frac + w_frac - out_frac.
+struct fx_linear_model {
+    const int32_t *weights;
+    int32_t bias;
+    uint16_t n_features;
+    uint8_t shift;
+};
+
+// Linear classifier (linear or logistic regression): one row of
+// n_features weights and one bias per class, same formats as above.
+// Logistic models only need the logits to pick a class, so no sigmoid.
+struct fx_linear_classifier {
+    const int32_t *weights;
+    const int32_t *biases;
+    uint16_t n_features;
+    uint16_t n_classes;
+    uint8_t shift;
+};
+
+// Arithmetic shift right with round-to-nearest
+static inline int32_t fx_shr_round(int64_t v, unsigned shift) {
+    if (shift == 0)
+        return (int32_t)v;
+    return (int32_t)((v + ((int64_t)1 << (shift - 1))) >> shift);
+}
+
+// Multiply two fixed-point values and drop `shift` fractional bits
+static inline int32_t fx_mul(int32_t a, int32_t b, unsigned shift) {
+    return fx_shr_round((int64_t)a * b, shift);
+}
+
+// Convert between Q formats
+static inline int32_t fx_convert(int32_t v, unsigned from_frac, unsigned to_frac) {
+    if (from_frac > to_frac)
+        return fx_shr_round(v, from_frac - to_frac);
+    return v << (to_frac - from_frac);
+}
+
+// Single-feature linear model: y = x * weight + bias
+static inline int32_t fx_linear1(int32_t x, int32_t weight, int32_t bias, unsigned shift) {
+    return fx_mul(x, weight, shift) + bias;
+}
+
+int32_t fx_dot(const int32_t *a, const int32_t *b, unsigned n, unsigned shift);
+int32_t fx_linear_predict(const struct fx_linear_model *m, const int32_t *x);
+void fx_linear_predict_batch(const struct fx_linear_model *m, const int32_t *x, int32_t *y, unsigned n);
+void fx_linear1_batch(int32_t weight, int32_t bias, unsigned shift, const int32_t *x, int32_t *y, unsigned n);
+
+unsigned fx_argmax(const int32_t *v, unsigned n);
+void fx_classifier_scores(const struct fx_linear_classifier *c, const int32_t *x, int32_t *scores);
+unsigned fx_classify(const struct fx_linear_classifier *c, const int32_t *x);
+void fx_classify_batch(const struct fx_linear_classifier *c, const int32_t *x, uint8_t *labels, unsigned n);
+
+#endif // __FIXED_KERNELS_H
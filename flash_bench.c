@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "inference_accel.h"
+#include "fixed_kernels.h"
+#include "diabetes_model.h"
+#include "flash_data.h"
+#include "dlog.h"
+
+#if __has_include("digits_swar_model.h")
+#define DIGITS_SWAR_AVAILABLE
+#include "digits_swar_model.h"
+#endif
+
+// Two SRAM buffers; records are 4 bytes (diabetes) or 64 bytes (digits)
+#define FLASH_STREAM_CHUNK 1024
+
+static uint8_t stream_buf[2][FLASH_STREAM_CHUNK] __attribute__((aligned(4)));
+
+#ifdef CSR_INFERENCE_ACCEL_BASE
+// Diabetes record (Q16.16) to the accelerator's Q format
+static inline int32_t diabetes_record_to_accel(int32_t x) {
+#if INFERENCE_ACCEL_FRAC_BITS >= FLASH_DIABETES_FRAC_BITS
+    return x << (INFERENCE_ACCEL_FRAC_BITS - FLASH_DIABETES_FRAC_BITS);
+#else
+    return x >> (FLASH_DIABETES_FRAC_BITS - INFERENCE_ACCEL_FRAC_BITS);
+#endif
+}
+#endif
+
+// Stream in progress, one chunk per flash_benchmark_step()
+static struct {
+    const struct flash_entry *e;
+    struct flash_stream s;
+    uint32_t records;
+    uint32_t ticks;
+    int32_t checksum;
+} fs;
+
+// Runs every record of a flash entry through the matching model while the
+// next chunk is prefetched one record at a time
+int flash_benchmark_start(const char *name) {
+    const struct flash_entry *e;
+
+    e = flash_data_find(name);
+    if (e == NULL) {
+        printf("Entry '%s' not found\n", name);
+        flash_data_list();
+        return -1;
+    }
+    if (flash_data_verify(e) != 0) {
+        printf("Entry '%s' CRC mismatch\n", name);
+        return -1;
+    }
+    if (e->record != 4 && e->record != 64) {
+        printf("Entry '%s' has no known record format\n", name);
+        return -1;
+    }
+#ifndef DIGITS_SWAR_AVAILABLE
+    if (e->record == 64) {
+        printf("Digits model not built in: run lgr_digit.py and rebuild\n");
+        return -1;
+    }
+#endif
+
+#ifdef CSR_INFERENCE_ACCEL_BASE
+    // The accelerator may hold another model (load-model, polynomial benchmark)
+    if (e->record == 4) {
+        inference_accel_set_params(DIABETES_WEIGHT, DIABETES_BIAS);
+        inference_accel_degree_write(1);
+    }
+#endif
+
+    dlog_printf("Streaming '%s' from SPI flash (%lu bytes)...\n", name, (unsigned long)e->length);
+    fs.e = e;
+    fs.records = 0;
+    fs.ticks = 0;
+    fs.checksum = 0;
+    flash_stream_init(&fs.s, e, stream_buf[0], stream_buf[1], FLASH_STREAM_CHUNK);
+    return 0;
+}
+
+// One chunk per call, timed on its own; the report sums the chunk times
+int flash_benchmark_step(void) {
+    const struct flash_entry *e = fs.e;
+    const uint8_t *buf;
+    uint32_t len, off;
+
+    start_stopwatch();
+
+    buf = flash_stream_next(&fs.s, &len);
+    if (buf != NULL) {
+        for (off = 0; off < len; off += e->record) {
+            if (e->record == 4) {
+                int32_t x = *(const int32_t *)(buf + off);
+#ifdef CSR_INFERENCE_ACCEL_BASE
+                fs.checksum += inference_accel_compute_fixed(diabetes_record_to_accel(x)) >> INFERENCE_ACCEL_FRAC_BITS;
+#else
+                fs.checksum += fx_linear1(x, DIABETES_WEIGHT_Q16, DIABETES_BIAS_Q16, 16) >> 16;
+#endif
+            }
+#ifdef DIGITS_SWAR_AVAILABLE
+            else {
+                fs.checksum += digits_swar_predict(&digits_swar_model, (const uint32_t *)(buf + off));
+            }
+#endif
+            fs.records++;
+            // Prefetch one record worth of the next chunk per inference
+            flash_stream_pump(&fs.s, e->record);
+        }
+    }
+
+    stop_stopwatch();
+    fs.ticks += elapsed_ticks;
+    if (buf != NULL)
+        return 1;
+
+    print_elapsed_time(fs.ticks, "SPI Flash Streaming Benchmark");
+    dlog_printf("Records: %lu, checksum: %ld\n", (unsigned long)fs.records, (long)fs.checksum);
+    dlog_flush();
+    return 0;
+}
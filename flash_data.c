@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <string.h>
+#include <generated/csr.h>
+#include <generated/mem.h>
+#include <libbase/crc.h>
+
+#include "flash_data.h"
+
+#if defined(SPIFLASH_BASE) && defined(FLASH_DATA_OFFSET)
+
+static const struct flash_pack_header *flash_header;
+static const struct flash_entry *flash_entries;
+
+static const uint8_t *flash_data_base(void) {
+    return (const uint8_t *)(SPIFLASH_BASE + FLASH_DATA_OFFSET);
+}
+
+// Returns 0 when a valid image is present in the data region
+int flash_data_open(void) {
+    const struct flash_pack_header *h = (const struct flash_pack_header *)flash_data_base();
+    const struct flash_entry *e = (const struct flash_entry *)(h + 1);
+
+    if (h->magic != FLASH_PACK_MAGIC || h->version != FLASH_PACK_VERSION)
+        return -1;
+    if (crc32((const unsigned char *)e, h->n_entries * sizeof(*e)) != h->header_crc)
+        return -2;
+
+    flash_header = h;
+    flash_entries = e;
+    return 0;
+}
+
+const struct flash_entry *flash_data_find(const char *name) {
+    unsigned i;
+
+    if (flash_header == NULL && flash_data_open() != 0)
+        return NULL;
+
+    for (i = 0; i < flash_header->n_entries; i++) {
+        if (strncmp(flash_entries[i].name, name, FLASH_PACK_NAME_LEN) == 0)
+            return &flash_entries[i];
+    }
+
+    return NULL;
+}
+
+const uint8_t *flash_data_ptr(const struct flash_entry *e) {
+    return flash_data_base() + e->offset;
+}
+
+int flash_data_verify(const struct flash_entry *e) {
+    return crc32(flash_data_ptr(e), e->length) == e->crc32 ? 0 : -1;
+}
+
+void flash_data_list(void) {
+    unsigned i;
+
+    if (flash_header == NULL && flash_data_open() != 0) {
+        printf("No data image at flash offset 0x%08lx\n", (unsigned long)FLASH_DATA_OFFSET);
+        return;
+    }
+
+    for (i = 0; i < flash_header->n_entries; i++) {
+        const struct flash_entry *e = &flash_entries[i];
+        printf("%-16.16s %8lu bytes", e->name, (unsigned long)e->length);
+        if (e->record)
+            printf(" (%lu records)", (unsigned long)(e->length / e->record));
+        printf("\n");
+    }
+}
+
+#else
+
+int flash_data_open(void) {
+    return -1;
+}
+
+const struct flash_entry *flash_data_find(const char *name) {
+    return NULL;
+}
+
+const uint8_t *flash_data_ptr(const struct flash_entry *e) {
+    return NULL;
+}
+
+int flash_data_verify(const struct flash_entry *e) {
+    return -1;
+}
+
+void flash_data_list(void) {
+    printf("SPI flash data region not available in this build\n");
+}
+
+#endif // SPIFLASH_BASE && FLASH_DATA_OFFSET
+
+/*-----------------------------------------------------------------------*/
+/* Double-buffered streaming                                             */
+/*-----------------------------------------------------------------------*/
+
+// chunk should be a multiple of the entry's record size
+void flash_stream_init(struct flash_stream *s, const struct flash_entry *e,
+                       uint8_t *buf0, uint8_t *buf1, uint32_t chunk) {
+    s->src = flash_data_ptr(e);
+    s->remaining = e->length;
+    s->chunk = chunk;
+    s->buf[0] = buf0;
+    s->buf[1] = buf1;
+    s->len[0] = 0;
+    s->len[1] = 0;
+    s->front = 1;       // nothing handed out yet, buffer 0 fills first
+    s->back_fill = 0;
+}
+
+// Copy up to max_bytes from flash into the back buffer
+// (called between inferences on the front buffer)
+void flash_stream_pump(struct flash_stream *s, uint32_t max_bytes) {
+    uint32_t n = s->chunk - s->back_fill;
+
+    if (n > s->remaining)
+        n = s->remaining;
+    if (n > max_bytes)
+        n = max_bytes;
+    if (n == 0)
+        return;
+
+    memcpy(s->buf[s->front ^ 1] + s->back_fill, s->src, n);
+    s->src += n;
+    s->remaining -= n;
+    s->back_fill += n;
+}
+
+// Finish the back buffer and hand it out; the old front buffer becomes the
+// new back buffer. Returns NULL at the end of the entry.
+const uint8_t *flash_stream_next(struct flash_stream *s, uint32_t *len) {
+    flash_stream_pump(s, s->chunk);
+    if (s->back_fill == 0)
+        return NULL;
+
+    s->front ^= 1;
+    s->len[s->front] = s->back_fill;
+    s->back_fill = 0;
+
+    *len = s->len[s->front];
+    return s->buf[s->front];
+}
@@ -0,0 +1,57 @@
+#ifndef __FLASH_DATA_H
+#define __FLASH_DATA_H
+
+#include <stdint.h>
+
+// Datasets and model blobs in the SPI flash data region (see flash_pack.py)
+//
+// Entries are read through the memory-mapped SPI flash and streamed into
+// two SRAM buffers: the caller infers on one buffer while the other is
+// refilled a slice at a time by flash_stream_pump(), so datasets larger
+// than main_ram can be evaluated.
+
+#define FLASH_PACK_MAGIC   0x4b415046 // "FPAK"
+#define FLASH_PACK_VERSION 1
+#define FLASH_PACK_NAME_LEN 16
+
+// 4-byte diabetes records (flash_pack.py --diabetes) are int32 Q16.16
+#define FLASH_DIABETES_FRAC_BITS 16
+
+struct flash_pack_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t n_entries;
+    uint32_t total_size;
+    uint32_t header_crc;
+};
+
+struct flash_entry {
+    char name[FLASH_PACK_NAME_LEN];
+    uint32_t offset;
+    uint32_t length;
+    uint32_t crc32;
+    uint32_t record;
+};
+
+struct flash_stream {
+    const uint8_t *src;         // next byte to read from flash
+    uint32_t remaining;         // bytes not yet copied to a buffer
+    uint32_t chunk;             // buffer size, a multiple of the record size
+    uint8_t *buf[2];
+    uint32_t len[2];            // valid bytes in each buffer
+    int front;                  // buffer handed to the caller
+    uint32_t back_fill;         // bytes already copied into the back buffer
+};
+
+int flash_data_open(void);
+const struct flash_entry *flash_data_find(const char *name);
+const uint8_t *flash_data_ptr(const struct flash_entry *e);
+int flash_data_verify(const struct flash_entry *e);
+void flash_data_list(void);
+
+void flash_stream_init(struct flash_stream *s, const struct flash_entry *e,
+                       uint8_t *buf0, uint8_t *buf1, uint32_t chunk);
+void flash_stream_pump(struct flash_stream *s, uint32_t max_bytes);
+const uint8_t *flash_stream_next(struct flash_stream *s, uint32_t *len);
+
+#endif // __FLASH_DATA_H
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+
+# Flash data image packer
+#
+# Packs datasets and model blobs into one image for the SPI flash data region
+# (sipeed_tang_nano_9k.py --data-image/--data-flash-offset). The firmware
+# (flash_data.c) finds entries by name and streams them into SRAM.
+#
+# Layout (little endian):
+#   u32 magic        FLASH_PACK_MAGIC
+#   u16 version      FLASH_PACK_VERSION
+#   u16 n_entries
+#   u32 total_size   whole image, header included
+#   u32 header_crc   CRC-32 of the entry table
+#   entries[n_entries]:
+#     char name[16]  NUL padded
+#     u32  offset    from the start of the image
+#     u32  length    bytes
+#     u32  crc32     CRC-32 of the data
+#     u32  record    record size in bytes (one sample), 0 for blobs
+#   data, each entry aligned to FLASH_PACK_ALIGN
+
+import argparse
+import struct
+import zlib
+
+FLASH_PACK_MAGIC   = 0x4b415046 # "FPAK"
+FLASH_PACK_VERSION = 1
+FLASH_PACK_ALIGN   = 256        # SPI flash page
+NAME_LEN           = 16
+HEADER_FMT         = "<IHHII"
+ENTRY_FMT          = "<{}sIIII".format(NAME_LEN)
+
+
+def align(v, a=FLASH_PACK_ALIGN):
+    return (v + a - 1) & ~(a - 1)
+
+
+def pack(entries):
+    """entries: list of (name, data bytes, record size) -> image bytes."""
+    table_size = struct.calcsize(HEADER_FMT) + len(entries) * struct.calcsize(ENTRY_FMT)
+    offset = align(table_size)
+    table = b""
+    data = b""
+    for name, blob, record in entries:
+        if len(name.encode()) >= NAME_LEN:
+            raise ValueError("entry name too long: {}".format(name))
+        if record and len(blob) % record:
+            raise ValueError("{}: {} bytes is not a multiple of the record size {}".format(name, len(blob), record))
+        table += struct.pack(ENTRY_FMT, name.encode(), offset, len(blob), zlib.crc32(blob) & 0xffffffff, record)
+        padded = blob + b"\xff" * (align(len(blob)) - len(blob))
+        data += padded
+        offset += len(padded)
+    header = struct.pack(HEADER_FMT, FLASH_PACK_MAGIC, FLASH_PACK_VERSION, len(entries), offset,
+        zlib.crc32(table) & 0xffffffff)
+    image = header + table
+    return image + b"\xff" * (align(len(image)) - len(image)) + data
+
+# Built-in datasets ----------------------------------------------------------------------------------
+
+def diabetes_dataset(frac_bits=16):
+    """Diabetes BMI feature as int32 Q(frac_bits), one record per sample
+    (the firmware reads them as FLASH_DIABETES_FRAC_BITS, flash_data.h)."""
+    import numpy as np
+    from sklearn.datasets import load_diabetes
+    X, y = load_diabetes(return_X_y=True)
+    q = np.round(X[:, 2] * (1 << frac_bits)).astype("<i4")
+    return q.tobytes(), 4
+
+
+def digits_dataset():
+    """Digits images as 64 uint8 pixels, one record per sample."""
+    import numpy as np
+    from sklearn.datasets import load_digits
+    X, y = load_digits(return_X_y=True)
+    return X.astype(np.uint8).tobytes(), 64
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack datasets and model blobs into a SPI flash data image.")
+    parser.add_argument("entries",    nargs="*",           help="name=file[:record_size] entries.")
+    parser.add_argument("--diabetes", action="store_true", help="Add the diabetes BMI feature (Q16.16) as 'diabetes'.")
+    parser.add_argument("--digits",   action="store_true", help="Add the digits images (uint8) as 'digits'.")
+    parser.add_argument("--output",   default="datasets.bin", help="Output image.")
+    args = parser.parse_args()
+
+    entries = []
+    if args.diabetes:
+        entries.append(("diabetes",) + diabetes_dataset())
+    if args.digits:
+        entries.append(("digits",) + digits_dataset())
+    for e in args.entries:
+        name, path = e.split("=", 1)
+        record = 0
+        if ":" in path:
+            path, record = path.rsplit(":", 1)
+            record = int(record, 0)
+        with open(path, "rb") as f:
+            entries.append((name, f.read(), record))
+
+    image = pack(entries)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    for name, blob, record in entries:
+        print("  {:<16} {:>8} bytes{}".format(name, len(blob), " ({} records)".format(len(blob) // record) if record else ""))
+    print("{} bytes written to {}".format(len(image), args.output))
+
+if __name__ == "__main__":
+    main()
@@ -7,81 +7,424 @@
 # SPDX-License-Identifier: BSD-2-Clause
 
 from migen import *
-from migen.genlib.misc import timeline
 
 from litex.build.io import DifferentialOutput
 
+from litex.gen import *
+
 from litex.soc.interconnect import wishbone
+from litex.soc.interconnect.csr import CSRStorage
+
+# HyperRAM Configuration Register 0 ----------------------------------------------------------------
+
+CR0_ADDRESS = 0x600001000000 # CA of a CR0 write (register space, zero latency)
+
+# Initial latency (clocks): CR0[7:4] code and highest HyperBus clock frequency.
+CR0_LATENCIES = {
+    3: (0b1110,  83e6),
+    4: (0b1111, 100e6),
+    5: (0b0000, 133e6),
+    6: (0b0001, 166e6), # Default.
+    7: (0b0010, 200e6),
+}
+
+# Wrapped burst length (bytes): CR0[1:0] code.
+CR0_BURST_LENGTHS = {16: 0b10, 32: 0b11, 64: 0b01, 128: 0b00}
+
+def hyperram_min_latency(clk_freq):
+    for latency, (code, max_freq) in sorted(CR0_LATENCIES.items()):
+        if clk_freq <= max_freq:
+            return latency
+    raise ValueError("No HyperRAM latency for a {:.0f} Hz clock".format(clk_freq))
+
+# Maximum CS# low time (tCSM), so the RAM can refresh between accesses.
+HYPERRAM_TCSM = 4e-6
+
+def hyperram_cs_low_clocks(latency, burst_words, dw=8):
+    # Command (3 clocks), worst case 2x latency, 32//dw beats per word (2 per clock), end.
+    return 3 + 2*latency + burst_words*(32//dw)//2 + 1
+
+def hyperram_max_burst_words(clk_freq, latency, dw=8, max_words=8):
+    burst_words = max_words
+    while burst_words > 1 and hyperram_cs_low_clocks(latency, burst_words, dw)/clk_freq > HYPERRAM_TCSM:
+        burst_words //= 2
+    return burst_words
+
+def hyperram_cr0(latency=6, variable_latency=False, burst_length=32, drive_strength=0b000):
+    return ((1 << 15)                               | # Normal operation (no Deep Power Down)
+            ((drive_strength & 0b111) << 12)        | # Drive strength (000: default impedance)
+            (0b1111 << 8)                           | # Reserved
+            (CR0_LATENCIES[latency][0] << 4)        | # Initial latency
+            ((0 if variable_latency else 1) << 3)   | # Fixed 2x latency
+            (1 << 2)                                | # Legacy wrapped bursts
+            CR0_BURST_LENGTHS[burst_length])          # Wrapped burst length
+
+# HyperRAM Gowin DDR PHY ---------------------------------------------------------------------------
+
+class HyperRAMGowinDDRPHY(LiteXModule):
+    """HyperRAM Gowin DDR PHY
+
+    Gowin ODDR/IDDR I/Os running the HyperBus clock at sys_clk/2 (clk_ratio="2:1") or sys_clk
+    (clk_ratio="1:1"). The controller provides bps beats per sys clock (1 or 2, in time order):
+
+    - Every output (CK, CS#, DQ, RWDS) goes through an ODDR so they all reach the pins with the
+      same latency.
+    - "2:1": one beat per sys clock, CK is toggled in the middle of each beat (ODDR D0/D1 = 0/1
+      then 1/0).
+    - "1:1": two beats per sys clock, CK is generated by an ODDR clocked by sys_ps (sys_clk
+      shifted by 90°), so its edges are in the middle of each beat.
+    - DQ/RWDS are captured by IDDRs (two samples per sys clock). The last 8 half sys clock samples
+      are kept and read_cal selects the capture point (in half sys clocks, higher is earlier): it
+      absorbs tCKD and the board/IO delays and can be calibrated at run time.
+
+    Experimental: the default read_cal assumes the primitive latencies and has not been measured
+    on hardware; sweep it with hyperram_calibrate.py and build with the measured value.
+    """
+    def __init__(self, pads, clk_ratio="2:1", read_cal=3):
+        assert clk_ratio in ["2:1", "1:1"]
+        self.bps = bps = {"2:1": 1, "1:1": 2}[clk_ratio]
+        dw = len(pads.dq)
+        rw = len(pads.rwds)
+
+        self.clk_en   = Signal()
+        self.cs_n     = Signal(len(pads.cs_n), reset=2**len(pads.cs_n) - 1)
+        self.dq_o     = [Signal(dw) for b in range(bps)]
+        self.dq_oe    = Signal()
+        self.dq_i     = [Signal(dw) for b in range(bps)]
+        self.rwds_o   = [Signal(rw) for b in range(bps)]
+        self.rwds_oe  = Signal()
+        self.rwds_i   = [Signal(rw) for b in range(bps)]
+        self.rwds_raw = Signal(rw) # Latest RWDS sample, without read_cal.
+        self.read_cal = Signal(3, reset=read_cal)
+
+        # # #
+
+        def oddr(d0, d1, q, clk="sys"):
+            self.specials += Instance("ODDR",
+                p_TXCLK_POL = 0,
+                i_CLK = ClockSignal(clk),
+                i_TX  = 0,
+                i_D0  = d0,
+                i_D1  = d1,
+                o_Q0  = q,
+            )
+
+        # Clock ------------------------------------------------------------------------------------
+        if clk_ratio == "2:1":
+            # Starts with a rising edge, the controller always sends an even number of beats.
+            ck_level = Signal()
+            self.sync += If(self.clk_en, ck_level.eq(~ck_level)).Else(ck_level.eq(0))
+            ck_d0 = self.clk_en &  ck_level
+            ck_d1 = self.clk_en & ~ck_level
+            ck_cd = "sys"
+        else:
+            # sys -> sys_ps (+90°) resync, so the ODDRs sample clk_en one sys clock later like the
+            # data (and the CK edges land 1/4 sys clock after the data transitions).
+            clk_en_ps = Signal()
+            self.sync.sys_ps += clk_en_ps.eq(self.clk_en)
+            ck_d0 = clk_en_ps
+            ck_d1 = 0
+            ck_cd = "sys_ps"
+        if hasattr(pads, "clk"):
+            for n in range(len(pads.clk)):
+                oddr(ck_d0, ck_d1, pads.clk[n], ck_cd)
+        else:
+            for n in range(len(pads.clk_p)):
+                oddr( ck_d0,  ck_d1, pads.clk_p[n], ck_cd)
+                oddr(~ck_d0, ~ck_d1, pads.clk_n[n], ck_cd)
+
+        # CS# --------------------------------------------------------------------------------------
+        for n in range(len(pads.cs_n)):
+            oddr(self.cs_n[n], self.cs_n[n], pads.cs_n[n])
+
+        # DQ/RWDS ----------------------------------------------------------------------------------
+        for pad, o, oe, i, raw in [
+            (pads.dq,   self.dq_o,   self.dq_oe,   self.dq_i,   None),
+            (pads.rwds, self.rwds_o, self.rwds_oe, self.rwds_i, self.rwds_raw)]:
+            width = len(pad)
+            q0    = Signal(width) # Rising edge sample.
+            q1    = Signal(width) # Falling edge sample (after q0).
+            for n in range(width):
+                pad_o   = Signal()
+                pad_oen = Signal()
+                pad_i   = Signal()
+                self.specials += Instance("ODDR",
+                    p_TXCLK_POL = 0,
+                    i_CLK = ClockSignal("sys"),
+                    i_TX  = ~oe,
+                    i_D0  = o[0][n],
+                    i_D1  = o[-1][n],
+                    o_Q0  = pad_o,
+                    o_Q1  = pad_oen,
+                )
+                self.specials += Instance("IOBUF",
+                    i_I   = pad_o,
+                    i_OEN = pad_oen,
+                    o_O   = pad_i,
+                    io_IO = pad[n],
+                )
+                self.specials += Instance("IDDR",
+                    i_CLK = ClockSignal("sys"),
+                    i_D   = pad_i,
+                    o_Q0  = q0[n],
+                    o_Q1  = q1[n],
+                )
+            if raw is not None:
+                self.comb += raw.eq(q1)
+
+            # Half sys clock samples, newest first; beat b of bps is read_cal + (bps-1-b) samples old.
+            samples = Signal(8*width)
+            self.sync += samples.eq(Cat(q1, q0, samples[:-2*width]))
+            cases = {}
+            for cal in range(8 - bps + 1):
+                cases[cal] = [i[b].eq(samples[width*(cal + bps-1-b):width*(cal + bps-b)]) for b in range(bps)]
+            cases["default"] = cases[8 - bps]
+            self.comb += Case(self.read_cal, cases)
 
 # HyperRAM -----------------------------------------------------------------------------------------
 
-class HyperRAM(Module):
+class HyperRAM(LiteXModule):
     """HyperRAM
 
     Provides a very simple/minimal HyperRAM core that should work with all FPGA/HyperRam chips:
-    - FPGA vendor agnostic.
-    - no setup/chip configuration (use default latency).
+    - FPGA vendor agnostic (clk_ratio="4:1", HyperBus clock at sys_clk/4).
+    - optional setup/chip configuration (with_config): CR0 is written after power-up with the
+      lowest latency allowed at the HyperBus clock, variable latency, the burst length and drive
+      strength; with_csr exposes it as a CSR that re-programs the chip when written. The
+      sequencer always follows the latency and latency mode of the last CR0 written (the chip's
+      defaults, 6 clocks fixed, without configuration).
+
+    Wishbone incrementing bursts (CTI/BTE) are served as HyperBus linear bursts: reads keep CS
+    asserted and stream up to burst_words consecutive words behind a single command and latency
+    (burst_words=1 disables it, None picks the longest burst up to 8 words that keeps CS low
+    within tCSM at sys_clk_freq), writes are single words. The next word is clocked while the
+    master shows an incrementing read; words it did not request (seen when their data is ready,
+    from the address) are dropped.
+
+    With variable latency, RWDS is sampled during the command and the second latency window is
+    only waited for when the RAM flags a refresh collision.
+
+    Two x8 dies with their own DQ/RWDS/CS# (pads.dq 16-bit, pads.cs_n 2-bit) can be used as:
+    - dual_die="interleaved": one 16-bit memory, both dies run each access in lockstep (each die
+      holds one byte of every beat). The dies refresh independently, so latency is fixed.
+    - dual_die="contiguous": one 8-bit memory of 2*die_size bytes, the address bit above die_size
+      selects the die.
+
+    clk_ratio="2:1" or "1:1" runs the HyperBus clock at sys_clk/2 or sys_clk through the Gowin
+    DDR PHY (HyperRAMGowinDDRPHY, "1:1" needs a sys_ps clock domain at +90°). These modes are
+    experimental: read_cal sets the read capture point (None: the PHY's unmeasured default) and
+    with_csr also exposes it for hyperram_calibrate.py.
 
     This core favors portability and ease of use over performance.
     """
-    def __init__(self, pads, latency=6):
+    def __init__(self, pads, latency=None, burst_words=4, variable_latency=None,
+        with_config    = False,
+        with_csr       = False,
+        sys_clk_freq   = None,
+        drive_strength = 0b000,
+        dual_die       = None,
+        die_size       = 4*2**20,
+        clk_ratio      = "4:1",
+        read_cal       = None):
         self.pads = pads
         self.bus  = bus = wishbone.Interface()
 
+        assert clk_ratio in ["4:1", "2:1", "1:1"]
+        ratio = {"4:1": 4, "2:1": 2, "1:1": 1}[clk_ratio]
+        if with_config:
+            assert sys_clk_freq is not None
+            self.latency          = hyperram_min_latency(sys_clk_freq/ratio) if latency is None else latency
+            self.variable_latency = (dual_die != "interleaved") if variable_latency is None else variable_latency
+        else:
+            self.latency          = 6 if latency is None else latency
+            self.variable_latency = bool(variable_latency)
+        if burst_words is None:
+            assert sys_clk_freq is not None
+
         # # #
 
+        # The sequencer runs in slots: one beat (4:1: 2 sys clocks, 2:1: 1 sys clock) or two beats
+        # (1:1: 1 sys clock). strobe marks the sys clock ending each slot.
+        cps = 2 if clk_ratio == "4:1" else 1 # Sys clocks per slot.
+        bps = 2 if clk_ratio == "1:1" else 1 # Beats per slot.
+
         clk       = Signal()
         clk_phase = Signal(2)
+        strobe    = Signal()
+        start     = Signal()
         cs        = Signal()
+        cs_n      = Signal(len(pads.cs_n))
         ca        = Signal(48)
         ca_active = Signal()
         sr        = Signal(48)
-        dq        = self.add_tristate(pads.dq)   if not hasattr(pads.dq,   "oe") else pads.dq
-        rwds      = self.add_tristate(pads.rwds) if not hasattr(pads.rwds, "oe") else pads.rwds
-        dw        = len(pads.dq)                 if not hasattr(pads.dq,   "oe") else len(pads.dq.o)
+        msk       = Signal(4)
+        load_ca   = Signal()
+        load_dat  = Signal()
+        load_cfg  = Signal()
+        cfg_issue = Signal()
+        cfg_value = Signal(16)
+        reg_write = Signal()
+        die       = Signal()
+        adr       = Signal(len(bus.adr))
+
+        assert dual_die in [None, "interleaved", "contiguous"]
+        self.comb += adr.eq(bus.adr)
+
+        # PHY --------------------------------------------------------------------------------------
+        # Per beat pad signals (dq_o/dq_i/rwds_o/rwds_i, bps beats in time order).
+        if clk_ratio == "4:1":
+            dq_t   = self.add_tristate(pads.dq)   if not hasattr(pads.dq,   "oe") else pads.dq
+            rwds_t = self.add_tristate(pads.rwds) if not hasattr(pads.rwds, "oe") else pads.rwds
+            dq_o,   dq_oe,   dq_i   = [dq_t.o],   dq_t.oe,   [dq_t.i]
+            rwds_o, rwds_oe, rwds_i = [rwds_t.o], rwds_t.oe, [rwds_t.i]
+            self.comb += pads.cs_n.eq(cs_n)
+            self.comb += strobe.eq((clk_phase == 0) | (clk_phase == 2)) # Shift on 0° and 180°
+            self.comb += start.eq(clk_phase == 0)
+            rd_delay = 1 # Slots from the end of a read word to its last beat in sr.
+        else:
+            phy_kwargs = {} if read_cal is None else {"read_cal": read_cal}
+            self.phy = phy = HyperRAMGowinDDRPHY(pads, clk_ratio, **phy_kwargs)
+            dq_o,   dq_oe,   dq_i   = phy.dq_o,   phy.dq_oe,   phy.dq_i
+            rwds_o, rwds_oe, rwds_i = phy.rwds_o, phy.rwds_oe, phy.rwds_i
+            self.comb += phy.cs_n.eq(cs_n)
+            self.comb += phy.clk_en.eq(cs)
+            self.comb += strobe.eq(1)
+            self.comb += start.eq(1)
+            rd_delay = 6 # ODDR + IDDR + sample history + dqi, read_cal centers the capture.
+            if with_csr:
+                self.read_cal = CSRStorage(3, reset=phy.read_cal.reset.value, description="DDR PHY read capture point (half sys clocks, higher is earlier).")
+                self.comb += phy.read_cal.eq(self.read_cal.storage)
+        dw = len(dq_o[0])
+
+        # Dual die ---------------------------------------------------------------------------------
+        if dual_die is not None:
+            assert dw == 16 and len(pads.cs_n) == 2
+        if dual_die == "interleaved":
+            assert not self.variable_latency
+        if dual_die == "contiguous":
+            # Both dies see the same outputs (only the selected one has CS# low), inputs come
+            # from the selected die. The die select bit is not part of the die's address.
+            dq_pads   = (dq_o,   dq_oe,   dq_i)
+            rwds_pads = (rwds_o, rwds_oe, rwds_i)
+            dq_o,   dq_oe,   dq_i   = [Signal(8) for b in range(bps)], Signal(), [Signal(8) for b in range(bps)]
+            rwds_o, rwds_oe, rwds_i = [Signal(1) for b in range(bps)], Signal(), [Signal(1) for b in range(bps)]
+            for (pad_o, pad_oe, pad_i), (o, oe, i) in [
+                (dq_pads,   (dq_o,   dq_oe,   dq_i)),
+                (rwds_pads, (rwds_o, rwds_oe, rwds_i))]:
+                w = len(o[0])
+                self.comb += pad_oe.eq(oe)
+                for b in range(bps):
+                    self.comb += [
+                        pad_o[b].eq(Replicate(o[b], 2)),
+                        i[b].eq(Mux(die, pad_i[b][w:], pad_i[b][:w])),
+                    ]
+            dw      = 8
+            die_bit = log2_int(die_size//4)
+            self.comb += adr[die_bit].eq(0)
+            self.sync += If(load_ca & ~cfg_issue, die.eq(bus.adr[die_bit]))
 
         assert dw in [8, 16]
+        mw = dw//8 # RWDS (mask) bits per beat.
+
+        # Bursts keep CS low, check them against tCSM when the clock is known.
+        if burst_words is None:
+            burst_words = hyperram_max_burst_words(sys_clk_freq/ratio, self.latency, dw)
+        assert burst_words >= 1 and (burst_words & (burst_words - 1)) == 0
+        if sys_clk_freq is not None and burst_words > 1:
+            cs_low = hyperram_cs_low_clocks(self.latency, burst_words, dw)*ratio/sys_clk_freq
+            assert cs_low <= HYPERRAM_TCSM, \
+                "{} word bursts keep CS low {:.2f}us, above tCSM".format(burst_words, cs_low*1e6)
+        self.burst_words = burst_words
+
+        # Configuration ----------------------------------------------------------------------------
+        # cr0 is the value the chip runs with, cfg_value the next one to write.
+        cr0_reset = hyperram_cr0(
+            latency          = self.latency,
+            variable_latency = self.variable_latency,
+            burst_length     = min(max(16, 4*burst_words), 128),
+            drive_strength   = drive_strength)
+        cr0         = Signal(16, reset=cr0_reset)
+        cfg_pending = Signal(reset=with_config)
+        self.sync += If(cfg_issue, cr0.eq(cfg_value))
+        if with_csr:
+            self.config = CSRStorage(16, reset=cr0_reset, description="CR0, written to the chip on update.")
+            self.comb += cfg_value.eq(self.config.storage)
+            self.sync += If(self.config.re, cfg_pending.eq(1)).Elif(cfg_issue, cfg_pending.eq(0))
+        else:
+            self.comb += cfg_value.eq(cr0_reset)
+            self.sync += If(cfg_issue, cfg_pending.eq(0))
+
+        # Wait tVCS (150us) after power-up before the first access.
+        cfg_ready = Signal(reset=1)
+        if with_config:
+            vcs_cycles = int(150e-6*sys_clk_freq) + 1
+            vcs_count  = Signal(max=vcs_cycles + 1, reset=vcs_cycles)
+            self.sync += If(vcs_count != 0, vcs_count.eq(vcs_count - 1))
+            self.comb += cfg_ready.eq(vcs_count == 0)
 
         # Drive rst_n, cs_n, clk from internal signals ---------------------------------------------
         if hasattr(pads, "rst_n"):
-            self.comb += pads.rst_n.eq(1)
-        self.comb += pads.cs_n[0].eq(~cs)
-        assert len(pads.cs_n) <= 2
-        if len(pads.cs_n) == 2:
-            self.comb += pads.cs_n[1].eq(1)
-        if hasattr(pads, "clk"):
-            self.comb += pads.clk.eq(clk)
+            self.comb += pads.rst_n.eq(2**len(pads.rst_n) - 1)
+        if dual_die == "interleaved":
+            self.comb += cs_n.eq(Replicate(~cs, 2))
+        elif dual_die == "contiguous":
+            # Register writes go to both dies
+            self.comb += cs_n[0].eq(~(cs & (reg_write | ~die)))
+            self.comb += cs_n[1].eq(~(cs & (reg_write |  die)))
         else:
-            self.specials += DifferentialOutput(clk, pads.clk_p, pads.clk_n)
+            self.comb += cs_n[0].eq(~cs)
+            assert len(pads.cs_n) <= 2
+            if len(pads.cs_n) == 2:
+                self.comb += cs_n[1].eq(1)
+        if clk_ratio == "4:1":
+            if hasattr(pads, "clk"):
+                self.comb += pads.clk.eq(clk)
+            else:
+                self.specials += DifferentialOutput(clk, pads.clk_p, pads.clk_n)
 
         # Clock Generation (sys_clk/4) -------------------------------------------------------------
-        self.sync += clk_phase.eq(clk_phase + 1)
-        cases = {}
-        cases[1] = clk.eq(cs) # Set pads clk on 90° (if cs is set)
-        cases[3] = clk.eq(0)  # Clear pads clk on 270°
-        self.sync += Case(clk_phase, cases)
+        if clk_ratio == "4:1":
+            self.sync += clk_phase.eq(clk_phase + 1)
+            cases = {}
+            cases[1] = clk.eq(cs) # Set pads clk on 90° (if cs is set)
+            cases[3] = clk.eq(0)  # Clear pads clk on 270°
+            self.sync += Case(clk_phase, cases)
 
         # Data Shift Register (for write and read) -------------------------------------------------
-        dqi = Signal(dw)
-        self.sync += dqi.eq(dq.i)  # Sample on 90° and 270°
+        dqi   = [Signal(dw) for b in range(bps)]
+        rwdsi = Signal(len(rwds_i[0]))
+        self.sync += [dqi[b].eq(dq_i[b]) for b in range(bps)] # 4:1: Sample on 90° and 270°
+        self.sync += rwdsi.eq(rwds_i[0])
         self.sync += [
-                If((clk_phase == 0) | (clk_phase == 2), # Shift on 0° and 180°
-                    # During Command-Address, only D[7:0] are used
-                    If(ca_active,
-                        sr.eq(Cat(dqi[:8], sr[:-8]))
-                    ).Else(
-                        sr.eq(Cat(dqi, sr[:-dw]))
-                    )
+            If(load_ca,
+                sr.eq(Mux(cfg_issue, CR0_ADDRESS, ca))
+            ).Elif(load_cfg,
+                # Register value MSB first, each byte on all byte lanes
+                sr[-2*dw:].eq(Cat(*[cfg_value[8*i:8*(i+1)] for i in range(2) for lane in range(dw//8)]))
+            ).Elif(load_dat,
+                sr[:16].eq(0),
+                sr[16:].eq(bus.dat_w),
+                msk.eq(~bus.sel)
+            ).Elif(strobe,
+                # During Command-Address, only D[7:0] are used
+                If(ca_active,
+                    sr.eq(Cat(*[dqi[b][:8] for b in reversed(range(bps))], sr[:-8*bps]))
+                ).Else(
+                    sr.eq(Cat(*reversed(dqi), sr[:-dw*bps])),
+                    msk.eq(Cat(Replicate(0, mw*bps), msk[:-mw*bps]))
                 )
-        ]
-        self.comb += [
-            bus.dat_r.eq(sr),      # To Wisbone
-            If(ca_active,
-                dq.o.eq(sr[-8:]),  # To HyperRAM, 8-bits mode
-            ).Else(
-                dq.o.eq(sr[-dw:]), # To HyperRAM, 16-bits mode
             )
         ]
+        self.comb += bus.dat_r.eq(sr) # To Wisbone
+        for b in range(bps):
+            self.comb += [
+                If(ca_active,
+                    dq_o[b].eq(Replicate(sr[48-8*(b+1):48-8*b], dw//8)), # To HyperRAM, 8-bits mode (all dies)
+                ).Else(
+                    dq_o[b].eq(sr[48-dw*(b+1):48-dw*b]),                 # To HyperRAM, 16-bits mode
+                ),
+                rwds_o[b].eq(msk[4-mw*(b+1):4-mw*b]),                    # Write/Read data mask
+            ]
 
         # Command generation -----------------------------------------------------------------------
         self.comb += [
@@ -91,77 +434,167 @@ class HyperRAM(Module):
 
         if dw == 8:
             self.comb += [
-                ca[16:45].eq(self.bus.adr[2:]), # Row & Upper Column Address
-                ca[1:3].eq(self.bus.adr[0:]),   # Lower Column Address
+                ca[16:45].eq(adr[2:]),          # Row & Upper Column Address
+                ca[1:3].eq(adr[0:]),            # Lower Column Address
                 ca[0].eq(0),                    # Lower Column Address
             ]
         else:
             self.comb += [
-                ca[16:45].eq(self.bus.adr[3:]), # Row & Upper Column Address
-                ca[1:3].eq(self.bus.adr[1:]),   # Lower Column Address
-                ca[0].eq(self.bus.adr[0]),      # Lower Column Address
+                ca[16:45].eq(adr[3:]),          # Row & Upper Column Address
+                ca[1:3].eq(adr[1:]),            # Lower Column Address
+                ca[0].eq(adr[0]),               # Lower Column Address
             ]
 
-        # Latency count starts from the middle of the command (it's where -4 comes from).
+        # Latency count starts from the middle of the command (it's where -2 beats come from).
         # In fixed latency mode (default), latency is 2*Latency count.
-        # Because we have 4 sys clocks per ram clock:
-        lat = (latency * 8) - 4
+        # In variable latency mode, it is 2*Latency count when RWDS is high during the command
+        # (refresh collision) and 1*Latency count otherwise.
+        # Because we have 2 beats per ram clock:
+        max_latency = max(CR0_LATENCIES)
+        lat         = Signal(max=max_latency*4)
+        lat_single  = Signal(max=max_latency*2)
+        lat_cases   = {code: [lat.eq((clks*4 - 2)//bps), lat_single.eq((clks*2 - 2)//bps)]
+            for clks, (code, max_freq) in CR0_LATENCIES.items()}
+        lat_cases["default"] = [lat.eq((max_latency*4 - 2)//bps), lat_single.eq((max_latency*2 - 2)//bps)]
+        self.comb += Case(cr0[4:8], lat_cases)
 
         # Sequencer --------------------------------------------------------------------------------
+        # Slot counts: command 6 beats, register write 2 beats, 32//dw beats per word.
+        ca_slots   = 6//bps
+        reg_slots  = 2//bps
+        word_slots = (32//dw)//bps
+        cnt        = Signal(max=max(ca_slots, max_latency*4, word_slots) + 1)
+        cur_we     = Signal()
+        clk_adr    = Signal(len(bus.adr)) # Word being clocked.
+        rd_adr     = Signal(len(bus.adr)) # Word being acked.
 
-        # Command.
-        # --------
-        dt_seq = [
-            # DT,  Action
-            (3,    []),
-            (12,   [cs.eq(1), dq.oe.eq(1), sr.eq(ca), ca_active.eq(1)]), # Command: 6 clk
-            (lat,  [dq.oe.eq(0), ca_active.eq(0)]),                      # Latency
-        ]
-
-        # Write/Read.
-        # -----------
-        rwdso = Signal(2)
-        self.comb += rwds.o.eq(rwdso)
-        if dw == 8:
-            dt_seq += [
-                (2,    [dq.oe.eq(self.bus.we),         # Write/Read data byte: 2 clk
-                        sr[:16].eq(0),
-                        sr[16:].eq(self.bus.dat_w),
-                        rwds.oe.eq(self.bus.we),
-                        rwdso[0].eq(~bus.sel[3])]),
-                (2,    [rwdso[0].eq(~bus.sel[2])]),    # Write/Read data byte: 2 clk
-                (2,    [rwdso[0].eq(~bus.sel[1])]),    # Write/Read data byte: 2 clk
-                (2,    [rwdso[0].eq(~bus.sel[0])]),    # Write/Read data byte: 2 clk
-            ]
-        if dw == 16:
-            dt_seq += [
-                (2,    [dq.oe.eq(self.bus.we),         # Write/Read data byte: 2 clk
-                        sr[:16].eq(0),
-                        sr[16:].eq(self.bus.dat_w),
-                        rwds.oe.eq(self.bus.we),
-                        rwdso[1].eq(~bus.sel[3]),
-                        rwdso[0].eq(~bus.sel[2])]),
-                (2,    [rwdso[1].eq(~bus.sel[1]),
-                        rwdso[0].eq(~bus.sel[0])]),    # Write/Read data byte: 2 clk
-            ]
+        # Incrementing reads continue the burst (CS stays asserted, no new Command/Latency). The
+        # burst is cut on each aligned block of burst_words words so CS low time stays bounded
+        # (tCSM) and a burst never crosses a row. Acks of consecutive words need 2 sys clocks
+        # (registered master), so there is no burst with 1 sys clock per word.
+        burst_next = Signal()
+        if burst_words > 1 and word_slots*cps >= 2:
+            self.comb += burst_next.eq(
+                bus.cyc & bus.stb & ~bus.we &
+                (bus.cti == 0b010) & (bus.bte == 0b00) &
+                (clk_adr[:log2_int(burst_words)] != (burst_words - 1)))
 
-        # End.
-        # ----
-        dt_seq += [
-            (2,    [cs.eq(0), rwds.oe.eq(0), dq.oe.eq(0)]),
-            (1,    [bus.ack.eq(1)]),
-            (1,    [bus.ack.eq(0)]),
-            (0,    [])
+        # Word acks: rd_delay slots after the end of each word (its last beat is then in sr), only
+        # when the master still requests that word.
+        ack_push = Signal()
+        ack_pop  = Signal()
+        ack_sr   = Signal(rd_delay)
+        self.comb += ack_pop.eq(strobe & ack_sr[-1])
+        self.sync += If(strobe, ack_sr.eq(Cat(ack_push, ack_sr)[:rd_delay]))
+        self.sync += [
+            bus.ack.eq(ack_pop & bus.cyc & bus.stb & (bus.we == cur_we) & (bus.adr == rd_adr)),
+            If(load_ca,
+                cur_we.eq(bus.we),
+                rd_adr.eq(bus.adr)
+            ).Elif(ack_pop,
+                rd_adr.eq(rd_adr + 1)
+            )
         ]
 
-        # Convert delta-time sequencer to time sequencer
-        t_seq = []
-        t_seq_start = (clk_phase == 1)
-        t = 0
-        for dt, a in dt_seq:
-            t_seq.append((t, a))
-            t += dt
-        self.sync += timeline(bus.cyc & bus.stb & t_seq_start, t_seq)
+        # RWDS is driven by the RAM from the start of the command: sampled on its last clk (4:1) or,
+        # through the PHY's latest sample, on the first latency slot (DDR, so it is valid at 1:1).
+        if clk_ratio == "4:1":
+            latency_start = If(cr0[3] | (rwdsi != 0),
+                NextValue(cnt, lat - 1)
+            ).Else(
+                NextValue(cnt, lat_single - 1)
+            )
+            latency_check = []
+        else:
+            latency_start = NextValue(cnt, lat - 1)
+            latency_check = If(~cr0[3] & (cnt == lat - 1) & (phy.rwds_raw == 0),
+                NextValue(cnt, lat_single - 2)
+            )
+
+        self.fsm = fsm = FSM(reset_state="IDLE")
+        fsm.act("IDLE",
+            If(start & cfg_pending & cfg_ready,
+                cfg_issue.eq(1),
+                load_ca.eq(1),
+                NextValue(reg_write, 1),
+                NextValue(cs, 1),
+                NextValue(dq_oe, 1),
+                NextValue(ca_active, 1),
+                NextValue(cnt, ca_slots - 1),
+                NextState("COMMAND")
+            ).Elif(start & bus.cyc & bus.stb & ~bus.ack & ~cfg_pending,
+                load_ca.eq(1),
+                NextValue(clk_adr, bus.adr),
+                NextValue(cs, 1),
+                NextValue(dq_oe, 1),
+                NextValue(ca_active, 1),
+                NextValue(cnt, ca_slots - 1),
+                NextState("COMMAND")
+            )
+        )
+        fsm.act("COMMAND", # Command: 3 clk
+            If(strobe,
+                NextValue(cnt, cnt - 1),
+                If(cnt == 0,
+                    NextValue(ca_active, 0),
+                    If(reg_write,
+                        load_cfg.eq(1),
+                        NextValue(cnt, reg_slots - 1),
+                        NextState("REGISTER")
+                    ).Else(
+                        NextValue(dq_oe, 0),
+                        latency_start,
+                        NextState("LATENCY")
+                    )
+                )
+            )
+        )
+        fsm.act("REGISTER", # Register write: 1 clk, no latency
+            If(strobe,
+                NextValue(cnt, cnt - 1),
+                If(cnt == 0,
+                    NextValue(cs, 0),
+                    NextValue(dq_oe, 0),
+                    NextValue(reg_write, 0),
+                    NextState("IDLE")
+                )
+            )
+        )
+        fsm.act("LATENCY",
+            If(strobe,
+                NextValue(cnt, cnt - 1),
+                latency_check,
+                If(cnt == 0,
+                    load_dat.eq(1),
+                    NextValue(dq_oe, cur_we),
+                    NextValue(rwds_oe, cur_we),
+                    NextValue(cnt, 1),
+                    NextState("DATA")
+                )
+            )
+        )
+        fsm.act("DATA", # Write/Read data: 32//dw beats per word
+            If(strobe,
+                NextValue(cnt, cnt + 1),
+                If(cnt == word_slots,
+                    ack_push.eq(1),
+                    NextValue(cnt, 1),
+                    If(burst_next,
+                        NextValue(clk_adr, clk_adr + 1)
+                    ).Else(
+                        NextValue(cs, 0),
+                        NextValue(rwds_oe, 0),
+                        NextValue(dq_oe, 0),
+                        NextState("END")
+                    )
+                )
+            )
+        )
+        fsm.act("END",
+            If(ack_sr == 0,
+                NextState("IDLE")
+            )
+        )
 
     def add_tristate(self, pad):
         t = TSTriple(len(pad))
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+
+# HyperRAM DDR PHY read capture calibration over the UART-to-Wishbone bridge, no CPU involved
+#
+#   python3 sipeed_tang_nano_9k.py --hyperram-clk-ratio 2:1 --uart-name crossover+uartbone --csr-csv csr.csv --build --load
+#   litex_server --uart --uart-port /dev/ttyUSB1
+#   python3 hyperram_calibrate.py --csr-csv csr.csv
+#
+# Main RAM is where the firmware runs, so a wrong capture point cannot be
+# calibrated from software. The bridge writes a pattern to main_ram (writes
+# do not depend on read_cal), reads it back at every hyperram_read_cal tap
+# and reports the center of the widest passing window: rebuild with
+# --hyperram-read-cal <tap> to make it the default.
+
+import argparse
+import random
+
+from litex import RemoteClient
+
+READ_CAL_TAPS = 8
+
+
+def pattern(n, seed):
+    """Walking ones/zeros then random words, so every DQ bit toggles both ways."""
+    words = [1 << (i % 32) for i in range(32)] + [~(1 << (i % 32)) & 0xffffffff for i in range(32)]
+    rng = random.Random(seed)
+    words += [rng.getrandbits(32) for _ in range(max(0, n - len(words)))]
+    return words[:n]
+
+
+def sweep(wb, base, words):
+    """Bit errors per read_cal tap."""
+    reg = wb.regs.hyperram_read_cal
+    saved = reg.read()
+    errors = []
+    try:
+        for tap in range(READ_CAL_TAPS):
+            reg.write(tap)
+            data = wb.read(base, len(words))
+            errors.append(sum(bin(a ^ b).count("1") for a, b in zip(data, words)))
+    finally:
+        reg.write(saved)
+    return errors
+
+
+def best_tap(errors):
+    """Center of the widest run of error-free taps, None if no tap passes."""
+    best, start = None, None
+    for tap in range(len(errors) + 1):
+        if tap < len(errors) and errors[tap] == 0:
+            start = tap if start is None else start
+        elif start is not None:
+            if best is None or tap - start > best[1] - best[0]:
+                best = (start, tap)
+            start = None
+    return None if best is None else (best[0] + best[1] - 1) // 2
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Sweep the HyperRAM DDR PHY read capture point (--hyperram-clk-ratio 2:1/1:1).")
+    parser.add_argument("--host",    default="localhost", help="litex_server host.")
+    parser.add_argument("--port",    default=1234, type=int, help="litex_server port.")
+    parser.add_argument("--csr-csv", default="csr.csv", help="CSR map written by the SoC build (--csr-csv).")
+    parser.add_argument("--words",   default=1024, type=int, help="Pattern words per tap.")
+    parser.add_argument("--offset",  default="0x0", help="Pattern offset in main_ram.")
+    parser.add_argument("--seed",    default=0, type=int, help="Random pattern seed.")
+    parser.add_argument("--apply",   action="store_true", help="Leave the chosen tap in hyperram_read_cal.")
+    args = parser.parse_args()
+
+    wb = RemoteClient(host=args.host, port=args.port, csr_csv=args.csr_csv)
+    wb.open()
+    try:
+        if not hasattr(wb.regs, "hyperram_read_cal"):
+            raise SystemExit("No hyperram_read_cal CSR: build with --hyperram-clk-ratio 2:1 or 1:1")
+        base = wb.mems.main_ram.base + int(args.offset, 0)
+        words = pattern(args.words, args.seed)
+        wb.write(base, words)
+
+        errors = sweep(wb, base, words)
+        for tap, e in enumerate(errors):
+            print("read_cal {}: {}".format(tap, "ok" if e == 0 else "{} bit errors".format(e)))
+        tap = best_tap(errors)
+        if tap is None:
+            raise SystemExit("No read_cal tap reads the pattern back")
+        print("Best read_cal: {} (rebuild with --hyperram-read-cal {})".format(tap, tap))
+        if args.apply:
+            wb.regs.hyperram_read_cal.write(tap)
+    finally:
+        wb.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -3,21 +3,44 @@
 
 #include <stdint.h>
 #include <generated/csr.h>
+#include <generated/mem.h>
+#include <generated/soc.h>
 
 #ifdef CSR_INFERENCE_ACCEL_BASE
 
 // Control register bits
 #define INFERENCE_ACCEL_CTRL_START  (1 << 0)
 #define INFERENCE_ACCEL_CTRL_RESET  (1 << 1)
+#define INFERENCE_ACCEL_CTRL_MODE   (1 << 2)  // Batch mode
 
 // Status register bits
 #define INFERENCE_ACCEL_STATUS_READY (1 << 0)
 #define INFERENCE_ACCEL_STATUS_DONE  (1 << 1)
 #define INFERENCE_ACCEL_STATUS_BUSY  (1 << 2)
 
-// Fixed point conversion macros (Q16.16 format)
-#define FLOAT_TO_FIXED(x) ((int32_t)((x) * 65536.0))
-#define FIXED_TO_FLOAT(x) (((double)(x)) / 65536.0)
+// Operand format, set by the SoC from the accelerator parameters (Q16.16 by default)
+#ifndef INFERENCE_ACCEL_DATA_WIDTH
+#define INFERENCE_ACCEL_DATA_WIDTH 32
+#endif
+#ifndef INFERENCE_ACCEL_FRAC_BITS
+#define INFERENCE_ACCEL_FRAC_BITS 16
+#endif
+#ifndef INFERENCE_ACCEL_MAX_DEGREE
+#define INFERENCE_ACCEL_MAX_DEGREE 1
+#endif
+
+// Fixed point conversion macros
+#define FLOAT_TO_FIXED(x) ((int32_t)((x) * (double)(1L << INFERENCE_ACCEL_FRAC_BITS)))
+#define FIXED_TO_FLOAT(x) (((double)(x)) / (double)(1L << INFERENCE_ACCEL_FRAC_BITS))
+
+// Sign-extend a data_width-bit register value
+static inline int32_t inference_accel_sign_extend(uint32_t v) {
+#if INFERENCE_ACCEL_DATA_WIDTH < 32
+    return (int32_t)(v << (32 - INFERENCE_ACCEL_DATA_WIDTH)) >> (32 - INFERENCE_ACCEL_DATA_WIDTH);
+#else
+    return (int32_t)v;
+#endif
+}
 
 
 static inline void inference_accel_reset(void) {
@@ -52,12 +75,39 @@ static inline void inference_accel_set_params_fixed(int32_t weight_fixed, int32_
     inference_accel_bias_write(bias_fixed);
 }
 
+// Polynomial mode: coefficients c0..c<degree> in ascending powers of x
+// (e.g. name_coeffs from fixed_codegen.generate_poly_header). c0 and c1 are
+// the bias and weight registers, the coeff2.. bank follows them in CSR space.
+static inline int inference_accel_set_poly(const int32_t *coeffs, unsigned degree) {
+    if (degree < 1 || degree > INFERENCE_ACCEL_MAX_DEGREE)
+        return -1;
+
+    inference_accel_bias_write(coeffs[0]);
+    inference_accel_weight_write(coeffs[1]);
+#ifdef CSR_INFERENCE_ACCEL_COEFF2_ADDR
+    {
+        const unsigned long stride = CSR_INFERENCE_ACCEL_WEIGHT_ADDR - CSR_INFERENCE_ACCEL_INPUT_DATA_ADDR;
+        unsigned k;
+
+        for (k = 2; k <= degree; k++) {
+            csr_write_simple(coeffs[k], CSR_INFERENCE_ACCEL_COEFF2_ADDR + (k - 2) * stride);
+        }
+    }
+#endif
+    inference_accel_degree_write(degree);
+    return 0;
+}
+
 static inline void inference_accel_wait_done(void) {
     while (!inference_accel_is_done()) {
         // Wait for completion
     }
 }
 
+static inline int32_t inference_accel_get_result_fixed(void) {
+    return inference_accel_sign_extend(inference_accel_result_read());
+}
+
 static inline int32_t inference_accel_compute_fixed(int32_t input_fixed) {
     // Wait until ready
     while (!inference_accel_is_ready()) {
@@ -75,7 +125,7 @@ static inline int32_t inference_accel_compute_fixed(int32_t input_fixed) {
     inference_accel_wait_done();
     
     // Return result
-    return inference_accel_result_read();
+    return inference_accel_sign_extend(inference_accel_result_read());
 }
 
 static inline int32_t inference_accel_compute(double input) {
@@ -83,13 +133,49 @@ static inline int32_t inference_accel_compute(double input) {
 }
 
 static inline double inference_accel_get_result_float(void) {
-    return FIXED_TO_FLOAT(inference_accel_result_read());
+    return FIXED_TO_FLOAT(inference_accel_get_result_fixed());
 }
 
-static inline int32_t inference_accel_get_result_fixed(void) {
-    return inference_accel_result_read();
+/*-----------------------------------------------------------------------*/
+/* Batch mode                                                            */
+/*-----------------------------------------------------------------------*/
+
+#ifdef INFERENCE_ACCEL_MEM_BASE
+
+// Two banks of INFERENCE_ACCEL_BATCH_DEPTH samples, inputs then results
+#define INFERENCE_ACCEL_MEM_WORDS (2 * INFERENCE_ACCEL_BATCH_DEPTH)
+
+static inline volatile int32_t *inference_accel_batch_inputs(unsigned bank) {
+    return (volatile int32_t *)INFERENCE_ACCEL_MEM_BASE + bank * INFERENCE_ACCEL_BATCH_DEPTH;
 }
 
+static inline volatile int32_t *inference_accel_batch_results(unsigned bank) {
+    return (volatile int32_t *)INFERENCE_ACCEL_MEM_BASE + INFERENCE_ACCEL_MEM_WORDS
+        + bank * INFERENCE_ACCEL_BATCH_DEPTH;
+}
+
+// Done is latched in the event pending register until the next start
+static inline int inference_accel_batch_is_done(void) {
+    return (inference_accel_ev_pending_read() & 1) != 0;
+}
+
+static inline void inference_accel_batch_start(unsigned bank, unsigned count) {
+    inference_accel_ev_pending_write(1);
+    inference_accel_batch_base_write(bank * INFERENCE_ACCEL_BATCH_DEPTH);
+    inference_accel_batch_count_write(count);
+    inference_accel_control_write(INFERENCE_ACCEL_CTRL_MODE);
+    inference_accel_control_write(INFERENCE_ACCEL_CTRL_MODE | INFERENCE_ACCEL_CTRL_START);
+    inference_accel_control_write(INFERENCE_ACCEL_CTRL_MODE);
+}
+
+static inline void inference_accel_batch_wait(void) {
+    while (!inference_accel_batch_is_done()) {
+        // Wait
+    }
+}
+
+#endif // INFERENCE_ACCEL_MEM_BASE
+
 #endif // CSR_INFERENCE_ACCEL_BASE
 
 #endif // __INFERENCE_ACCEL_H
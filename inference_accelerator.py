@@ -1,25 +1,96 @@
+import json
+
 from migen import *
 from litex.gen import *
 from litex.soc.integration.soc_core import *
 from litex.soc.integration.soc import SoCRegion
 from litex.soc.interconnect.csr import CSRStatus, CSRStorage
+from litex.soc.interconnect.csr_eventmanager import EventManager, EventSourcePulse
+from litex.soc.interconnect import wishbone
 from litex.gen.fhdl.module import LiteXModule
 
+def load_accel_format(path):
+    """InferenceAccelerator arguments from a quant_calibrate.py format file."""
+    with open(path) as f:
+        fmt = json.load(f)
+    if "accel" not in fmt:
+        raise ValueError("{} has no accelerator format".format(path))
+    return dict(data_width=fmt["accel"]["data_width"], frac_bits=fmt["accel"]["frac_bits"])
+
+def add_inference_accelerator(soc, accel_format=None, **kwargs):
+    """Add InferenceAccelerator to `soc` with its sample memory, IRQ and constants."""
+    if accel_format is not None:
+        kwargs.update(load_accel_format(accel_format))
+    soc.inference_accel = accel = InferenceAccelerator(**kwargs)
+    soc.bus.add_slave("inference_accel_mem", accel.bus,
+        region=SoCRegion(size=accel.mem_size, cached=False))
+    if soc.irq.enabled:
+        soc.irq.add("inference_accel", use_loc_if_exists=True)
+    soc.add_constant("INFERENCE_ACCEL_DATA_WIDTH",  accel.data_width)
+    soc.add_constant("INFERENCE_ACCEL_FRAC_BITS",   accel.frac_bits)
+    soc.add_constant("INFERENCE_ACCEL_BATCH_DEPTH", accel.batch_depth)
+    soc.add_constant("INFERENCE_ACCEL_MAX_DEGREE",  accel.max_degree)
+    return accel
+
 class InferenceAccelerator(LiteXModule):
     """
-    Hardware accelerator for linear inference: y = x * weight + bias
-    Supports both floating point and fixed point operations
+    Hardware accelerator for polynomial inference:
+        y = c0 + c1*x + c2*x^2 + ... + cN*x^N
+    evaluated with a pipelined Horner scheme, one multiply-add per stage:
+        acc = cN; acc = (acc * x >> frac_bits) + c(k) for k = N-1 .. 0
+    Operands are signed fixed point, data_width bits with frac_bits fractional bits
+    (Q16.16 by default, see quant_calibrate.py to pick a narrower format)
+
+    max_degree sets the number of pipeline stages and the size of the coefficient
+    bank: bias (c0), weight (c1), then coeff2 .. coeffN. The degree register selects
+    the degree at run time, coefficients above it read as zero; with degree 1 (the
+    reset value) the accelerator is the plain linear y = x * weight + bias.
+
+    Batch mode (MODE bit) runs batch_count samples from the input memory, starting
+    at batch_base, into the result memory, one sample per cycle. Both memories hold
+    two banks of batch_depth words and are mapped on the bus (inputs first, then
+    results), so the CPU can fill one bank while the accelerator processes the
+    other. The end of a batch raises the done event (IRQ).
+
+    The cycles register holds the duration of the last operation in sys_clk cycles,
+    e.g. for accel_bridge_bench.py to time the accelerator without the CPU.
     """
-    def __init__(self, data_width=32):
+    def __init__(self, data_width=32, frac_bits=16, batch_depth=64, max_degree=1):
+        assert 0 <= frac_bits < data_width <= 32
+        assert max_degree >= 1
         self.data_width = data_width
+        self.frac_bits = frac_bits
+        self.batch_depth = batch_depth
+        self.max_degree = max_degree
+        fmt = "Q{}.{}".format(data_width - frac_bits, frac_bits)
+        mem_depth = 2*batch_depth
+        mem_aw = log2_int(mem_depth)
+        self.mem_size = 2*mem_depth*4 # Input memory then result memory, in bytes
         
         # CSR Registers
-        self.input_data = CSRStorage(data_width, description="Input data (Q16.16 fixed point)")
-        self.weight = CSRStorage(data_width, description="Weight coefficient (Q16.16 fixed point)")
-        self.bias = CSRStorage(data_width, description="Bias value (Q16.16 fixed point)")
-        self.result = CSRStatus(data_width, description="Result output (Q16.16 fixed point)")
+        self.input_data = CSRStorage(data_width, description="Input data ({} fixed point)".format(fmt))
+        self.weight = CSRStorage(data_width, description="Weight coefficient, c1 ({} fixed point)".format(fmt))
+        self.bias = CSRStorage(data_width, description="Bias value, c0 ({} fixed point)".format(fmt))
+        # Higher order coefficients, contiguous after bias so firmware can index the bank
+        coeffs = []
+        for k in range(2, max_degree + 1):
+            csr = CSRStorage(data_width, name="coeff{}".format(k),
+                description="Coefficient c{} ({} fixed point)".format(k, fmt))
+            setattr(self, "coeff{}".format(k), csr)
+            coeffs.append(csr)
+        self.degree = CSRStorage(bits_for(max_degree), reset=1,
+            description="Polynomial degree (1 to {})".format(max_degree))
+        self.result = CSRStatus(data_width, description="Result output ({} fixed point)".format(fmt))
         self.control = CSRStorage(8, description="Control register")
         self.status = CSRStatus(8, description="Status register")
+        self.batch_base = CSRStorage(mem_aw, description="Batch mode: index of the first sample")
+        self.batch_count = CSRStorage(mem_aw + 1, description="Batch mode: number of samples")
+        self.cycles = CSRStatus(32, description="Cycles taken by the last operation (start to done)")
+        
+        # Events
+        self.ev = EventManager()
+        self.ev.done = EventSourcePulse(description="Batch done")
+        self.ev.finalize()
         
         # Control bits
         self.START_BIT = 0
@@ -40,10 +111,16 @@ class InferenceAccelerator(LiteXModule):
         self.busy = Signal()
         
         # Computation pipeline
-        self.compute_valid = Signal()
-        self.mult_result = Signal(64)
-        self.add_result = Signal(64)
-        self.final_result = Signal(32)
+        self.start_d = Signal()
+        self.x = Signal((data_width, True))
+        self.in_valid = Signal()            # x enters the pipeline
+        self.in_idx = Signal(mem_aw + 1)    # batch index travelling with x
+        self.rd_idx = Signal(mem_aw + 1)    # batch mode: next sample to read
+        self.rd_valid = Signal()            # batch mode: in_acc.dat_r holds sample in_idx
+        self.wr_count = Signal(mem_aw + 1)  # batch mode: results written
+        self.final_result = Signal((data_width, True))
+        self.final_valid = Signal()
+        self.final_idx = Signal(mem_aw + 1)
         
         # Connect control signals
         self.comb += [
@@ -63,11 +140,28 @@ class InferenceAccelerator(LiteXModule):
         self.fsm = FSM(reset_state="IDLE")
         self.submodules += self.fsm
         
+        self.sync += self.start_d.eq(self.start)
+        
+        # Done stays set in IDLE until the next operation starts, so a slow
+        # poller (CPU or a host over the bridge) cannot miss it
         self.fsm.act("IDLE",
             NextValue(self.ready, 1),
-            NextValue(self.done, 0),
             NextValue(self.busy, 0),
-            If(self.start,
+            If(self.start & self.mode,
+                # Batch mode starts on the rising edge of START only
+                If(~self.start_d,
+                    NextValue(self.rd_idx, 0),
+                    NextValue(self.wr_count, 0),
+                    NextValue(self.ready, 0),
+                    NextValue(self.done, 0),
+                    NextValue(self.busy, 1),
+                    If(self.batch_count.storage == 0,
+                        NextState("BATCH_DONE")
+                    ).Else(
+                        NextState("BATCH")
+                    )
+                )
+            ).Elif(self.start,
                 NextState("COMPUTE")
             ),
             If(self.reset,
@@ -77,15 +171,42 @@ class InferenceAccelerator(LiteXModule):
         
         self.fsm.act("COMPUTE",
             NextValue(self.ready, 0),
+            NextValue(self.done, 0),
             NextValue(self.busy, 1),
-            NextValue(self.compute_valid, 1),
-            NextState("FINISH")
+            NextState("WAIT")
+        )
+        
+        # Wait for the sample to leave the pipeline (max_degree cycles)
+        self.fsm.act("WAIT",
+            If(self.final_valid,
+                NextState("FINISH")
+            )
         )
         
         self.fsm.act("FINISH",
             NextValue(self.done, 1),
             NextValue(self.busy, 0),
-            NextValue(self.compute_valid, 0),
+            NextState("IDLE")
+        )
+        
+        # Batch mode: issue one read per cycle (1 cycle memory latency), results are
+        # written back as they leave the pipeline
+        self.fsm.act("BATCH",
+            If(self.rd_idx != self.batch_count.storage,
+                NextValue(self.rd_idx, self.rd_idx + 1)
+            ),
+            If(self.final_valid,
+                NextValue(self.wr_count, self.wr_count + 1),
+                If(self.wr_count == (self.batch_count.storage - 1),
+                    NextState("BATCH_DONE")
+                )
+            )
+        )
+        
+        self.fsm.act("BATCH_DONE",
+            self.ev.done.trigger.eq(1),
+            NextValue(self.done, 1),
+            NextValue(self.busy, 0),
             NextState("IDLE")
         )
         
@@ -93,24 +214,104 @@ class InferenceAccelerator(LiteXModule):
             NextValue(self.ready, 0),
             NextValue(self.done, 0),
             NextValue(self.busy, 0),
-            NextValue(self.compute_valid, 0),
             NextState("IDLE")
         )
         
-        # Computation pipeline (combinatorial for simplicity)
-        # y = x * weight + bias (all in Q16.16 fixed point format)
+        # Cycle counter, measures the accelerator alone (no CPU or bus in the loop)
+        self.sync += [
+            If(self.fsm.before_leaving("IDLE"),
+                self.cycles.status.eq(1)
+            ).Elif(~self.fsm.ongoing("IDLE"),
+                self.cycles.status.eq(self.cycles.status + 1)
+            )
+        ]
+        
+        # Sample memories ----------------------------------------------------------------------
+        self.in_mem = Memory(32, mem_depth)
+        self.out_mem = Memory(32, mem_depth)
+        in_bus = self.in_mem.get_port(write_capable=True)
+        in_acc = self.in_mem.get_port()
+        out_bus = self.out_mem.get_port()
+        out_acc = self.out_mem.get_port(write_capable=True)
+        self.specials += self.in_mem, self.out_mem, in_bus, in_acc, out_bus, out_acc
+        
+        # Wishbone side (one cycle read latency)
+        self.bus = bus = wishbone.Interface(data_width=32)
+        bus_out_sel = Signal()
+        self.comb += [
+            bus_out_sel.eq(bus.adr[mem_aw]),
+            in_bus.adr.eq(bus.adr[:mem_aw]),
+            in_bus.dat_w.eq(bus.dat_w),
+            in_bus.we.eq(bus.cyc & bus.stb & bus.we & ~bus.ack & ~bus_out_sel),
+            out_bus.adr.eq(bus.adr[:mem_aw]),
+            bus.dat_r.eq(Mux(bus_out_sel, out_bus.dat_r, in_bus.dat_r)),
+        ]
+        self.sync += [
+            bus.ack.eq(0),
+            If(bus.cyc & bus.stb & ~bus.ack,
+                bus.ack.eq(1)
+            )
+        ]
+        
+        # Accelerator side
+        self.sync += [
+            self.rd_valid.eq(self.fsm.ongoing("BATCH") & (self.rd_idx != self.batch_count.storage)),
+            If(self.fsm.ongoing("BATCH"),
+                self.in_idx.eq(self.rd_idx)
+            ),
+        ]
+        self.comb += [
+            in_acc.adr.eq(self.batch_base.storage + self.rd_idx),
+            out_acc.adr.eq(self.batch_base.storage + self.final_idx),
+            out_acc.dat_w.eq(self.final_result),
+            out_acc.we.eq(self.fsm.ongoing("BATCH") & self.final_valid),
+            self.in_valid.eq(Mux(self.mode, self.rd_valid, self.fsm.ongoing("COMPUTE"))),
+            # Signed view of the operand (sample memory in batch mode)
+            self.x.eq(Mux(self.mode, in_acc.dat_r[:data_width], self.input_data.storage)),
+        ]
+        
+        # Horner pipeline ----------------------------------------------------------------------
+        # Coefficient bank, c[k] reads as zero above the programmed degree
+        bank = [self.bias, self.weight] + coeffs
+        c = []
+        for k, csr in enumerate(bank):
+            ck = Signal((data_width, True), name="c{}".format(k))
+            self.comb += ck.eq(Mux(self.degree.storage >= k, csr.storage, 0))
+            c.append(ck)
+        
+        # Stage 0 is the input; stage i holds acc = (acc * x >> frac_bits) + c[N-i]
+        n = max_degree
+        acc   = [Signal((data_width, True)) for i in range(n + 1)]
+        x     = [Signal((data_width, True)) for i in range(n + 1)]
+        valid = [Signal() for i in range(n + 1)]
+        idx   = [Signal(mem_aw + 1) for i in range(n + 1)]
+        self.comb += [
+            acc[0].eq(c[n]),
+            x[0].eq(self.x),
+            valid[0].eq(self.in_valid),
+            idx[0].eq(self.in_idx),
+        ]
+        for i in range(1, n + 1):
+            # Multiply: acc * x (data_width x data_width -> 2*data_width result)
+            product = Signal((2*data_width, True))
+            self.comb += product.eq(acc[i-1] * x[i-1])
+            self.sync += [
+                # Shift back to the operand format, add the next coefficient, truncate
+                acc[i].eq((product >> frac_bits) + c[n-i]),
+                x[i].eq(x[i-1]),
+                valid[i].eq(valid[i-1] & ~self.fsm.ongoing("RESET")),
+                idx[i].eq(idx[i-1]),
+            ]
+        
         self.comb += [
-            # Multiply: input * weight (32x32 -> 64 bit result)
-            self.mult_result.eq(self.input_data.storage * self.weight.storage),
-            # Add bias (shift multiplication result back to Q16.16)
-            self.add_result.eq((self.mult_result >> 16) + self.bias.storage),
-            # Final result (clamp to 32 bits)
-            self.final_result.eq(self.add_result[:32]),
+            self.final_result.eq(acc[n]),
+            self.final_valid.eq(valid[n]),
+            self.final_idx.eq(idx[n]),
         ]
         
-        # Update result register when computation is valid
+        # Update result register when a single operation leaves the pipeline
         self.sync += [
-            If(self.compute_valid,
+            If(self.final_valid & ~self.mode,
                 self.result.status.eq(self.final_result)
             )
         ]
@@ -0,0 +1,223 @@
+#ifndef __INFERENCE_KERNELS_HPP
+#define __INFERENCE_KERNELS_HPP
+
+// Header-only C++ inference kernels specialised at compile time
+//
+// Model shape (feature count, class count) and fixed-point formats are
+// template parameters and weights are template arguments, so each product
+// is a multiply by a compile-time constant and every loop is unrolled by
+// the recursive templates below. Small models such as the one-feature
+// diabetes regressor fold down to a handful of instructions.
+//
+// Only C++11 features are used and nothing needs exceptions, RTTI or the
+// C++ runtime, so the objects link with the plain C firmware.
+
+#include <stdint.h>
+
+namespace ik {
+
+// Power-of-two Q format: real value v is stored as round(v * 2^FracBits)
+template <int FracBits>
+struct Q {
+    static_assert(FracBits >= 0 && FracBits < 31, "invalid Q format");
+    static constexpr int frac_bits = FracBits;
+
+    static constexpr int32_t from(double v) {
+        return (int32_t)(v * (double)(1L << FracBits) + (v >= 0 ? 0.5 : -0.5));
+    }
+};
+
+// Rounding arithmetic shift right by a compile-time amount
+template <int Shift>
+inline int32_t shr_round(int64_t v) {
+    return Shift == 0 ? (int32_t)v
+                      : (int32_t)((v + ((int64_t)1 << (Shift > 0 ? Shift - 1 : 0))) >> Shift);
+}
+
+// Weight/bias vector passed as template arguments
+template <int32_t... Ws>
+struct Row {
+    static constexpr int size = sizeof...(Ws);
+};
+
+// Fully unrolled dot product of x with a compile-time Row
+template <typename R, int I = 0>
+struct RowDot;
+
+template <int I, int32_t W0, int32_t... Ws>
+struct RowDot<Row<W0, Ws...>, I> {
+    static inline int64_t run(const int32_t *x) {
+        return (int64_t)x[I] * W0 + RowDot<Row<Ws...>, I + 1>::run(x);
+    }
+};
+
+template <int I>
+struct RowDot<Row<>, I> {
+    static inline int64_t run(const int32_t *) {
+        return 0;
+    }
+};
+
+// Element I of a Row
+template <typename R, int I>
+struct RowAt;
+
+template <int32_t W0, int32_t... Ws>
+struct RowAt<Row<W0, Ws...>, 0> {
+    static constexpr int32_t value = W0;
+};
+
+template <int I, int32_t W0, int32_t... Ws>
+struct RowAt<Row<W0, Ws...>, I> {
+    static constexpr int32_t value = RowAt<Row<Ws...>, I - 1>::value;
+};
+
+// Activations (applied in the output format)
+struct Identity {
+    static inline int32_t apply(int32_t v) { return v; }
+};
+
+struct ReLU {
+    static inline int32_t apply(int32_t v) { return v > 0 ? v : 0; }
+};
+
+// Linear regression: y = x . W + Bias
+// x is In, weights are W, bias and y are Out.
+template <typename In, typename W, typename Out, int32_t Bias, typename Weights>
+struct LinearRegressor {
+    static constexpr int features = Weights::size;
+    static constexpr int shift = In::frac_bits + W::frac_bits - Out::frac_bits;
+    static_assert(shift >= 0, "output format finer than input * weight");
+
+    static inline int32_t predict(const int32_t *x) {
+        return shr_round<shift>(RowDot<Weights>::run(x)) + Bias;
+    }
+
+    static inline void predict_batch(const int32_t *x, int32_t *y, unsigned n) {
+        for (unsigned i = 0; i < n; i++) {
+            y[i] = predict(x);
+            x += features;
+        }
+    }
+};
+
+// Dense layer: out[k] = Act(x . Rows[k] + Biases[k]), one Row per output
+template <typename In, typename W, typename Out, typename Act, typename Biases, typename... Rows>
+struct Dense {
+    static constexpr int inputs = RowAt<Row<Rows::size...>, 0>::value;
+    static constexpr int outputs = sizeof...(Rows);
+    static constexpr int shift = In::frac_bits + W::frac_bits - Out::frac_bits;
+    static_assert(shift >= 0, "output format finer than input * weight");
+    static_assert(Biases::size == outputs, "one bias per output");
+
+    template <int K, typename... Rs>
+    struct Unit;
+
+    template <int K, typename R0, typename... Rs>
+    struct Unit<K, R0, Rs...> {
+        static_assert(R0::size == inputs, "all rows must have the same width");
+        static inline void run(const int32_t *x, int32_t *y) {
+            y[K] = Act::apply(shr_round<shift>(RowDot<R0>::run(x)) + RowAt<Biases, K>::value);
+            Unit<K + 1, Rs...>::run(x, y);
+        }
+    };
+
+    template <int K>
+    struct Unit<K> {
+        static inline void run(const int32_t *, int32_t *) {}
+    };
+
+    static inline void run(const int32_t *x, int32_t *y) {
+        Unit<0, Rows...>::run(x, y);
+    }
+};
+
+// Unrolled argmax (first maximum wins)
+template <int N, int I = 1>
+struct ArgMax {
+    static inline unsigned run(const int32_t *v, unsigned best) {
+        return ArgMax<N, I + 1>::run(v, v[I] > v[best] ? I : best);
+    }
+};
+
+template <int N>
+struct ArgMax<N, N> {
+    static inline unsigned run(const int32_t *, unsigned best) {
+        return best;
+    }
+};
+
+// Linear classifier (logistic regression uses the logits directly)
+// One class: binary model, class 1 when the logit is positive.
+template <typename In, typename W, typename Out, typename Biases, typename... Rows>
+struct LinearClassifier {
+    typedef Dense<In, W, Out, Identity, Biases, Rows...> Layer;
+    static constexpr int features = Layer::inputs;
+    static constexpr int classes = Layer::outputs == 1 ? 2 : Layer::outputs;
+
+    static inline void scores(const int32_t *x, int32_t *s) {
+        Layer::run(x, s);
+    }
+
+    static inline unsigned predict(const int32_t *x) {
+        int32_t s[Layer::outputs];
+        Layer::run(x, s);
+        if (Layer::outputs == 1)
+            return s[0] > 0;
+        return ArgMax<Layer::outputs>::run(s, 0);
+    }
+
+    static inline void predict_batch(const int32_t *x, uint8_t *labels, unsigned n) {
+        for (unsigned i = 0; i < n; i++) {
+            labels[i] = (uint8_t)predict(x);
+            x += features;
+        }
+    }
+};
+
+template <typename In, typename W, typename Out, typename Biases, typename... Rows>
+using LogisticClassifier = LinearClassifier<In, W, Out, Biases, Rows...>;
+
+// Small MLP: a chain of Dense layers, buffers sized at compile time.
+// Each layer's In must match the previous layer's Out.
+template <typename... Layers>
+struct MLP;
+
+template <typename L>
+struct MLP<L> {
+    static constexpr int inputs = L::inputs;
+    static constexpr int outputs = L::outputs;
+
+    static inline void run(const int32_t *x, int32_t *y) {
+        L::run(x, y);
+    }
+
+    static inline unsigned predict(const int32_t *x) {
+        int32_t s[outputs];
+        run(x, s);
+        return ArgMax<outputs>::run(s, 0);
+    }
+};
+
+template <typename L0, typename L1, typename... Ls>
+struct MLP<L0, L1, Ls...> {
+    static_assert(L0::outputs == L1::inputs, "layer widths do not chain");
+    static constexpr int inputs = L0::inputs;
+    static constexpr int outputs = MLP<L1, Ls...>::outputs;
+
+    static inline void run(const int32_t *x, int32_t *y) {
+        int32_t h[L0::outputs];
+        L0::run(x, h);
+        MLP<L1, Ls...>::run(h, y);
+    }
+
+    static inline unsigned predict(const int32_t *x) {
+        int32_t s[outputs];
+        run(x, s);
+        return ArgMax<outputs>::run(s, 0);
+    }
+};
+
+} // namespace ik
+
+#endif // __INFERENCE_KERNELS_HPP
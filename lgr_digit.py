@@ -5,7 +5,52 @@ from sklearn.datasets import load_digits
 from sklearn.linear_model import LogisticRegression
 from sklearn.model_selection import train_test_split
 from sklearn.metrics import accuracy_score
-from micromlgen import port
+from fixed_codegen import export, generate_swar_header, generate_cascade_header, generate_dataset_header, quantize
+
+CASCADE_FEATURES  = 16    # Stage-1 pixels
+CASCADE_FRAC_BITS = 12    # Stage-1 weight/logit format
+CASCADE_AGREEMENT = 0.995 # Min agreement with the full model on early exits
+
+def stage1_scores(weights_q, biases_q, X, pixels):
+    """Integer stage-1 logits as computed by digits_cascade.c."""
+    return X[:, pixels].astype(np.int64) @ weights_q.T + biases_q
+
+def margins(scores):
+    top2 = np.sort(scores, axis=1)[:, -2:]
+    return top2[:, 1] - top2[:, 0]
+
+def export_cascade(clf, X_train, y_train, X_test, path="digits_cascade_model.h"):
+    # Pixel importance: weight magnitude over all classes times pixel spread
+    importance = np.abs(clf.coef_).sum(axis=0) * X_train.std(axis=0)
+    pixels = np.sort(np.argsort(-importance)[:CASCADE_FEATURES])
+
+    # Stage-1 model on the selected pixels, threshold calibrated on held-out data
+    X_fit, X_val, y_fit, y_val = train_test_split(X_train, y_train, test_size=0.25, random_state=0)
+    stage1 = LogisticRegression(multi_class="multinomial", solver="lbfgs", max_iter=1000)
+    stage1.fit(X_fit[:, pixels], y_fit)
+    weights_q = quantize(stage1.coef_, CASCADE_FRAC_BITS)
+    biases_q = quantize(stage1.intercept_, CASCADE_FRAC_BITS)
+
+    val_scores = stage1_scores(weights_q, biases_q, X_val, pixels)
+    val_margin = margins(val_scores)
+    val_agree = val_scores.argmax(axis=1) == clf.predict(X_val)
+
+    # Smallest margin whose early exits still agree with the full model
+    margin = int(val_margin.max()) + 1
+    for t in np.unique(val_margin):
+        exits = val_margin >= t
+        if val_agree[exits].mean() >= CASCADE_AGREEMENT:
+            margin = int(t)
+            break
+
+    test_scores = stage1_scores(weights_q, biases_q, X_test, pixels)
+    exits = margins(test_scores) >= margin
+    print(f"Cascade: {CASCADE_FEATURES} stage-1 pixels, margin {margin}, "
+          f"early exit {exits.mean():.1%} of test samples")
+
+    with open(path, "w") as f:
+        f.write(generate_cascade_header("digits_cascade_model", pixels, weights_q, biases_q,
+            CASCADE_FRAC_BITS, margin))
 
 def main():
     # 1. Load digits dataset (1797 samples, 64 features) :contentReference[oaicite:1]{index=1}
@@ -28,11 +73,22 @@ def main():
     accuracy = accuracy_score(y_test, clf.predict(X_test))
     print(f"Test accuracy: {accuracy:.3f}")
 
-    # 5. Export model to C/C++ code
-    code = port(clf, classmap={i: str(i) for i in range(10)})
-    with open("digits_lr_model.cpp", "w") as f:
-        f.write(code)
-    print("✅ Generated digits_lr_model.cpp with predict() function")
+    # 5. Export model to fixed-point C (pixels are integers 0-16, so Q32.0 inputs)
+    export(clf, "digits_lr_model", path="digits_lr_model.h",
+        in_frac_bits=0, w_frac_bits=16, out_frac_bits=16,
+        classmap={i: str(i) for i in range(10)})
+    print("✅ Generated digits_lr_model.h with digits_lr_model_predict() function")
+
+    # 6. Export int8 packed weights for the SWAR kernel and the test set for the benchmark
+    with open("digits_swar_model.h", "w") as f:
+        f.write(generate_swar_header(clf, "digits_swar_model"))
+    with open("digits_test_data.h", "w") as f:
+        f.write(generate_dataset_header(X_test, y_test, "digits_test"))
+    print("✅ Generated digits_swar_model.h and digits_test_data.h")
+
+    # 7. Export the early-exit cascade (stage-1 pixels, weights and margin threshold)
+    export_cascade(clf, X_train, y_train, X_test)
+    print("✅ Generated digits_cascade_model.h")
 
 if __name__ == "__main__":
     main()
@@ -20,12 +20,12 @@ print("Score no teste (R²):", regressor.score(X_test, y_test))
 # Exibe a primeira predição
 print("Primeira predição:", y_pred[0])
 
-from micromlgen import port
+from fixed_codegen import export
 
-# Exporta o modelo LinearRegression treinado para código C (TinyML)
-with open('diabetes_regressor.h', 'w') as f:
-  f.write(port(regressor, classname="diabetes_regressor_predict"))
-print("Modelo exportado para diabetes_regressor.h")
+# Exporta o modelo LinearRegression treinado para código C em ponto fixo (Q16.16)
+# e o blob de parâmetros do acelerador
+export(regressor, "diabetes_regressor", path="diabetes_regressor.h", blob_path="diabetes_regressor.bin")
+print("Modelo exportado para diabetes_regressor.h e diabetes_regressor.bin")
 
 # Exemplo de código C para executar o modelo exportado (coloque no seu projeto C/C++)
 c_code = """
@@ -33,9 +33,10 @@ c_code = """
 #include <stdio.h>
 
 int main() {
-  // Exemplo de entrada (substitua pelo seu valor)
-  float input[1] = {0.03}; // valor da feature
-  printf("Predição: %f\\n", predict(input));
+  // Exemplo de entrada em Q16.16 (0.03 * 65536)
+  int32_t input[DIABETES_REGRESSOR_N_FEATURES] = {1966}; // valor da feature
+  int32_t y = diabetes_regressor_predict(input);
+  printf("Predição (Q16.16): %ld (%ld)\\n", (long)y, (long)(y >> DIABETES_REGRESSOR_OUT_FRAC_BITS));
   return 0;
 }
 """
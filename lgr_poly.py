@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+
+# Polynomial regression on one diabetes feature
+#
+# The linear fit of lgr_microlgen.py underfits (low R²); quadratic or cubic
+# features help. Trains PolynomialFeatures + LinearRegression for each degree,
+# prints the test R² and exports the chosen degree as Horner coefficients for
+# the accelerator's polynomial mode (build the SoC with --accel-degree >= degree).
+# The same polynomial is also written as an interpolated table (lut_codegen.py)
+# for the CPU LUT benchmark.
+
+import argparse
+
+from sklearn.datasets import load_diabetes
+from sklearn.linear_model import LinearRegression
+from sklearn.pipeline import make_pipeline
+from sklearn.preprocessing import PolynomialFeatures
+
+from fixed_codegen import export_polynomial, horner, poly_max_frac_bits, polynomial_params, quantize
+from lut_codegen import build_lut, generate_header as generate_lut_header
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Train and export a polynomial diabetes regressor.")
+    parser.add_argument("--degree",     default=2,  type=int,     help="Exported polynomial degree.")
+    parser.add_argument("--max-degree", default=4,  type=int,     help="Highest degree to report.")
+    parser.add_argument("--frac-bits",  default=16, type=int,     help="Q format of the accelerator (INFERENCE_ACCEL_FRAC_BITS).")
+    parser.add_argument("--name",       default="diabetes_poly", help="C identifier prefix / output name.")
+    parser.add_argument("--lut-name",   default="diabetes_lut",  help="Interpolated table name (also header file name).")
+    parser.add_argument("--lut-max-error", default=0.5, type=float, help="Max table interpolation error (output units).")
+    args = parser.parse_args()
+
+    X, y = load_diabetes(return_X_y=True)
+    X = X[:, [2]]  # Same single feature as lgr_microlgen.py
+    n_test = 20
+    X_train, X_test, y_train, y_test = X[:-n_test], X[-n_test:], y[:-n_test], y[-n_test:]
+
+    models = {}
+    print("degree  R² (float)  R² (fixed)  max frac bits")
+    for degree in range(1, max(args.degree, args.max_degree) + 1):
+        model = make_pipeline(PolynomialFeatures(degree), LinearRegression()).fit(X_train, y_train)
+        coeffs = polynomial_params(model)
+        frac_bits = min(args.frac_bits, poly_max_frac_bits(coeffs))
+        c_q = quantize(coeffs, frac_bits)
+        y_fixed = [horner(c_q, x, frac_bits) / (1 << frac_bits) for x in quantize(X_test[:, 0], frac_bits)]
+        r2_fixed = 1 - ((y_test - y_fixed) ** 2).sum() / ((y_test - y_test.mean()) ** 2).sum()
+        print("{:>6}  {:>10.4f}  {:>10.4f}  {:>13}".format(degree, model.score(X_test, y_test), r2_fixed,
+            poly_max_frac_bits(coeffs)))
+        models[degree] = model
+
+    path = export_polynomial(models[args.degree], args.name, blob_path="{}.bin".format(args.name),
+        frac_bits=args.frac_bits)
+    print("Degree {} model exported to {} and {}.bin".format(args.degree, path, args.name))
+
+    # LUT of the exported polynomial over the dataset range
+    model = models[args.degree]
+    f = lambda xs: [float(v) for v in model.predict([[x] for x in xs])]
+    x_min_q, seg_shift, table, err = build_lut(f, float(X.min()), float(X.max()), max_error=args.lut_max_error)
+    if err > args.lut_max_error:
+        raise SystemExit("LUT error {:.6g} above {} with {} entries".format(err, args.lut_max_error, len(table)))
+    lut_path = "{}.h".format(args.lut_name)
+    with open(lut_path, "w") as f_lut:
+        f_lut.write(generate_lut_header(args.lut_name, x_min_q, seg_shift, table, err, 16, 16,
+            "degree {} polynomial on diabetes BMI".format(args.degree)))
+    print("{} entries, segment 2^{}, max error {:.6g} -> {}".format(len(table), seg_shift, err, lut_path))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include <generated/csr.h>
+#include <generated/mem.h>
+#include <generated/soc.h>
+#include <system.h>
+#include <libbase/crc.h>
+
+// LZ4 loader stub (demo_lz4.bin, see lz4_pack.py)
+//
+// loader_crt0.S copies this code to SRAM and calls loader_main(), which
+// expands the compressed demo.bin that follows the stub to the start of
+// main_ram and jumps to its _start. No libbase console: the stub talks to
+// the UART registers directly so it stays small.
+
+#define LZ4_IMAGE_MAGIC 0x4c345a4c // "LZ4L"
+#define LZ4_MIN_MATCH   4
+
+struct lz4_image_header {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t packed_size;
+    uint32_t crc32;
+};
+
+extern const uint8_t _payload_start[];
+extern const uint8_t _loader_start[];
+
+void loader_main(void) __attribute__((noreturn));
+
+static void loader_puts(const char *s) {
+#ifdef CSR_UART_BASE
+    while (*s) {
+        while (uart_txfull_read()) {
+            // Wait
+        }
+        uart_rxtx_write(*s++);
+    }
+#endif
+}
+
+static void loader_puthex(uint32_t v) {
+    char s[11];
+    int i;
+
+    s[0] = '0';
+    s[1] = 'x';
+    for (i = 0; i < 8; i++) {
+        s[2 + i] = "0123456789abcdef"[(v >> (28 - 4 * i)) & 0xf];
+    }
+    s[10] = 0;
+    loader_puts(s);
+}
+
+static unsigned lz4_length(const uint8_t **ip, const uint8_t *iend, unsigned len) {
+    unsigned b;
+
+    if (len != 15)
+        return len;
+    do {
+        if (*ip >= iend)
+            return ~0u;
+        b = *(*ip)++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+// LZ4 block decoder, returns the decompressed size or -1 on a corrupt block
+static int lz4_decompress(const uint8_t *src, unsigned src_len, uint8_t *dst, unsigned dst_len) {
+    const uint8_t *ip = src, *iend = src + src_len, *match;
+    uint8_t *op = dst, *oend = dst + dst_len;
+    unsigned token, len, offset;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        // Literals
+        len = lz4_length(&ip, iend, token >> 4);
+        if (len > (unsigned)(iend - ip) || len > (unsigned)(oend - op))
+            return -1;
+        while (len--) {
+            *op++ = *ip++;
+        }
+        // The last sequence has no match
+        if (ip == iend)
+            break;
+
+        // Match, may overlap the output it copies
+        if (iend - ip < 2)
+            return -1;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (unsigned)(op - dst))
+            return -1;
+        len = lz4_length(&ip, iend, token & 15);
+        if (len == ~0u || len + LZ4_MIN_MATCH > (unsigned)(oend - op))
+            return -1;
+        len += LZ4_MIN_MATCH;
+        match = op - offset;
+        while (len--) {
+            *op++ = *match++;
+        }
+    }
+
+    return op - dst;
+}
+
+static void loader_fail(const char *msg) {
+    loader_puts("LZ4 loader: ");
+    loader_puts(msg);
+    loader_puts(", halted\n");
+    for (;;) {
+        // Wait for a reset
+    }
+}
+
+void loader_main(void) {
+    const struct lz4_image_header *h = (const struct lz4_image_header *)_payload_start;
+    uint8_t *dst = (uint8_t *)MAIN_RAM_BASE;
+    int size;
+
+    if (h->magic != LZ4_IMAGE_MAGIC)
+        loader_fail("no compressed image");
+    // The output grows from the start of main_ram towards the stub and its payload
+    if (h->size > (uint32_t)(_loader_start - dst))
+        loader_fail("image does not fit below the loader");
+
+    loader_puts("LZ4 loader: ");
+    loader_puthex(h->packed_size);
+    loader_puts(" -> ");
+    loader_puthex(h->size);
+    loader_puts(" bytes\n");
+
+    size = lz4_decompress(_payload_start + sizeof(*h), h->packed_size, dst, h->size);
+    if (size != (int)h->size)
+        loader_fail("corrupt image");
+    if (crc32(dst, h->size) != h->crc32)
+        loader_fail("CRC mismatch");
+
+    loader_puts("LZ4 loader: booting ");
+    loader_puthex(MAIN_RAM_BASE);
+    loader_puts("\n");
+
+    // As the BIOS does before jumping to a loaded image
+    flush_cpu_icache();
+    flush_cpu_dcache();
+#ifdef CONFIG_L2_SIZE
+    flush_l2_cache();
+#endif
+    ((void (*)(void))MAIN_RAM_BASE)();
+    for (;;) {
+        // Not reached
+    }
+}
@@ -19,7 +19,20 @@ from litex.tools.litex_sim  import sim_args
 from litex.tools.litex_sim  import SimSoC
 from litex.tools.litex_sim import generate_gtkw_savefile
 
-from inference_accelerator import InferenceAccelerator
+from inference_accelerator import add_inference_accelerator
+
+# UART-to-Wishbone bridge pads, same stream interface as the sim "serial" pads
+_uartbone_io = [
+    ("uartbone", 0,
+        Subsignal("source_valid", Pins(1)),
+        Subsignal("source_ready", Pins(1)),
+        Subsignal("source_data",  Pins(8)),
+
+        Subsignal("sink_valid",   Pins(1)),
+        Subsignal("sink_ready",   Pins(1)),
+        Subsignal("sink_data",    Pins(8)),
+    ),
+]
 
 class LocalSimSoc(SimSoC):
     def __init__(self,
@@ -47,6 +60,9 @@ class LocalSimSoc(SimSoC):
         sim_debug              = False,
         trace_reset_on         = False,
         with_jtag              = False,
+        accel_format           = None,
+        accel_degree           = 1,
+        with_uartbone          = False,
         **kwargs):
         SimSoC.__init__(self,
             with_sdram,
@@ -76,7 +92,15 @@ class LocalSimSoc(SimSoC):
             **kwargs
         )
 
-        self.inference_accel = InferenceAccelerator()
+        add_inference_accelerator(self, accel_format, max_degree=accel_degree)
+
+        # UARTBone: a second sim UART that masters the bus, for litex_server/RemoteClient
+        if with_uartbone:
+            from litex.soc.cores.uart import RS232PHYModel, UARTBone
+            self.platform.add_extension(_uartbone_io)
+            self.uartbone_phy = RS232PHYModel(self.platform.request("uartbone"))
+            self.uartbone = UARTBone(phy=self.uartbone_phy, clk_freq=self.sys_clk_freq)
+            self.bus.add_master(name="uartbone", master=self.uartbone.wishbone)
 
 
 def main():
@@ -84,6 +108,11 @@ def main():
     parser = LiteXArgumentParser(description="LiteX SoC Simulation utility")
     parser.set_platform(SimPlatform)
     sim_args(parser)
+    parser.add_argument("--accel-format", default=None, help="Accelerator fixed-point format file (from quant_calibrate.py).")
+    parser.add_argument("--accel-degree", default=1, type=int, help="Highest polynomial degree supported by the accelerator.")
+    parser.add_argument("--flash-data-offset", default=None, help="Data image offset in the SPI flash (with --spi-flash-init).")
+    parser.add_argument("--with-uartbone", action="store_true", help="Add a UART-to-Wishbone bridge (litex_server --uart).")
+    parser.add_argument("--uartbone-port", default=2430, type=int, help="Local TCP port of the bridge UART (serial2tcp).")
     args = parser.parse_args()
 
     soc_kwargs = soc_core_argdict(args)
@@ -99,6 +128,10 @@ def main():
         soc_kwargs["uart_name"] = "sim"
         sim_config.add_module("serial2console", "serial")
 
+    # UARTBone (local TCP socket, no tap interface needed).
+    if args.with_uartbone:
+        sim_config.add_module("serial2tcp", "uartbone", args={"port": args.uartbone_port})
+
     # Create config SoC that will be used to prepare/configure real one.
     conf_soc = SimSoC(**soc_kwargs)
 
@@ -179,7 +212,12 @@ def main():
         sim_debug              = args.sim_debug,
         trace_reset_on         = int(float(args.trace_start)) > 0 or int(float(args.trace_end)) > 0,
         spi_flash_init         = None if args.spi_flash_init is None else get_mem_data(args.spi_flash_init, endianness="big"),
+        accel_format           = args.accel_format,
+        accel_degree           = args.accel_degree,
+        with_uartbone          = args.with_uartbone,
         **soc_kwargs)
+    if args.with_spi_flash and args.flash_data_offset is not None:
+        soc.add_constant("FLASH_DATA_OFFSET", int(args.flash_data_offset, 0))
     if ram_boot_address is not None:
         if ram_boot_address == 0:
             ram_boot_address = conf_soc.mem_map["main_ram"]
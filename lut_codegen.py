@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+
+# LUT generator for bounded single-feature models
+#
+# Samples any model form (linear, polynomial, tree, optionally through a
+# sigmoid) on a power-of-two grid and emits the table for lut_kernels.h.
+# The grid is refined until integer linear interpolation stays within the
+# requested error bound (or the table size limit is reached).
+#
+# diabetes_lut.h is written by lgr_poly.py from the exported polynomial, so
+# the benchmark compares the LUT against the same nonlinear model.
+
+import argparse
+import math
+
+INT32_MIN = -(1 << 31)
+INT32_MAX = (1 << 31) - 1
+
+
+def interp(table, x_min, seg_shift, x):
+    """Integer interpolation exactly as lut_interp() in lut_kernels.h."""
+    off = x - x_min
+    if off <= 0:
+        return table[0]
+    i = off >> seg_shift
+    if i >= len(table) - 1:
+        return table[-1]
+    frac = off & ((1 << seg_shift) - 1)
+    return table[i] + (((table[i + 1] - table[i]) * frac) >> seg_shift)
+
+
+def build_lut(f, x_min, x_max, in_frac_bits=16, out_frac_bits=16, max_error=0.5,
+    max_entries=1024, n_checks=8192):
+    """Return (x_min_q, seg_shift, table, error) for model f(list of x) -> list of y."""
+    in_scale, out_scale = float(1 << in_frac_bits), float(1 << out_frac_bits)
+    x0 = int(math.floor(x_min * in_scale))
+    x1 = int(math.ceil(x_max * in_scale))
+    span = max(1, x1 - x0)
+
+    # Error is checked on a fixed set of inputs spread over the range
+    step = max(1, span // n_checks)
+    checks = list(range(x0, x1 + 1, step))
+    ref = f([x / in_scale for x in checks])
+
+    best = None
+    seg_shift = max(0, int(math.ceil(math.log2(span))))
+    while seg_shift >= 0:
+        n_segments = (span + (1 << seg_shift) - 1) >> seg_shift
+        if n_segments + 1 > max_entries:
+            break
+        xs = [x0 + (i << seg_shift) for i in range(n_segments + 1)]
+        table = [int(round(y * out_scale)) for y in f([x / in_scale for x in xs])]
+        if min(table) < INT32_MIN or max(table) > INT32_MAX:
+            raise ValueError("Q{} output format overflows int32".format(out_frac_bits))
+        err = max(abs(interp(table, x0, seg_shift, x) / out_scale - y) for x, y in zip(checks, ref))
+        if best is None or err < best[3]:
+            best = (x0, seg_shift, table, err)
+        if err <= max_error:
+            break
+        seg_shift -= 1
+    return best
+
+
+def generate_header(name, x_min_q, seg_shift, table, err, in_frac_bits, out_frac_bits, description):
+    upper = name.upper()
+    guard = "__{}_H".format(upper)
+    out = []
+    out.append("// Generated by lut_codegen.py ({}) - do not edit".format(description))
+    out.append("#ifndef {}".format(guard))
+    out.append("#define {}".format(guard))
+    out.append("")
+    out.append("#include \"lut_kernels.h\"")
+    out.append("")
+    out.append("// Input Q{}.{}, output Q{}.{}, max interpolation error {:.6g}".format(
+        32 - in_frac_bits, in_frac_bits, 32 - out_frac_bits, out_frac_bits, err))
+    out.append("#define {}_IN_FRAC_BITS  {}".format(upper, in_frac_bits))
+    out.append("#define {}_OUT_FRAC_BITS {}".format(upper, out_frac_bits))
+    out.append("#define {}_MAX_ERROR     \"{:.6g}\"".format(upper, err))
+    out.append("")
+    out.append("static const int32_t {}_y[{}] = {{".format(name, len(table)))
+    for i in range(0, len(table), 8):
+        out.append("    " + ", ".join(str(v) for v in table[i:i + 8]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("static const struct lut_table {} = {{".format(name))
+    out.append("    {}, {}, {}, {}_y".format(x_min_q, seg_shift, len(table) - 1, name))
+    out.append("};")
+    out.append("")
+    out.append("#endif // {}".format(guard))
+    return "\n".join(out) + "\n"
+
+# Models ---------------------------------------------------------------------------------------------
+
+def sigmoid(v):
+    return 1.0 / (1.0 + math.exp(-v))
+
+
+def diabetes_model(kind, degree):
+    """Train `kind` on the diabetes BMI feature, return (f, x_min, x_max, description)."""
+    import numpy as np
+    from sklearn.datasets import load_diabetes
+    from sklearn.model_selection import train_test_split
+    from sklearn.linear_model import LinearRegression
+    from sklearn.pipeline import make_pipeline
+    from sklearn.preprocessing import PolynomialFeatures
+    from sklearn.tree import DecisionTreeRegressor
+
+    X, y = load_diabetes(return_X_y=True)
+    X = X[:, [2]] # Same single feature as lgr_microlgen.py
+    X_train, X_test, y_train, y_test = train_test_split(X, y, test_size=20, shuffle=False)
+    if kind == "poly":
+        model = make_pipeline(PolynomialFeatures(degree), LinearRegression())
+    elif kind == "tree":
+        model = DecisionTreeRegressor(max_depth=degree)
+    else:
+        model = LinearRegression()
+    model.fit(X_train, y_train)
+    print("Score no teste (R²): {}".format(model.score(X_test, y_test)))
+
+    def f(xs):
+        return [float(v) for v in model.predict(np.asarray(xs).reshape(-1, 1))]
+    return f, float(X.min()), float(X.max()), "{} on diabetes BMI".format(type(model).__name__)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate an interpolated LUT for a single-feature model.")
+    parser.add_argument("--model",         default="linear", choices=["linear", "poly", "tree"], help="Model trained on the diabetes BMI feature.")
+    parser.add_argument("--degree",        default=3,        type=int,   help="Polynomial degree / tree depth.")
+    parser.add_argument("--linear",        default=None,     type=float, nargs=2, metavar=("W", "B"),
+        help="Use y = W*x + B instead of training (no sklearn needed).")
+    parser.add_argument("--sigmoid",       action="store_true",          help="Pass the model output through a sigmoid.")
+    parser.add_argument("--x-min",         default=None,     type=float, help="Lower input bound (default: dataset min).")
+    parser.add_argument("--x-max",         default=None,     type=float, help="Upper input bound (default: dataset max).")
+    parser.add_argument("--in-frac-bits",  default=16,       type=int,   help="Input fractional bits.")
+    parser.add_argument("--out-frac-bits", default=16,       type=int,   help="Output fractional bits.")
+    parser.add_argument("--max-error",     default=0.5,      type=float, help="Max interpolation error (output units).")
+    parser.add_argument("--max-entries",   default=1024,     type=int,   help="Table size limit.")
+    parser.add_argument("--name",          default="diabetes_lut",       help="Table name (also header file name).")
+    args = parser.parse_args()
+
+    if args.linear is not None:
+        w, b = args.linear
+        f = lambda xs: [w * x + b for x in xs]
+        x_min, x_max, description = args.x_min, args.x_max, "y = {!r} * x + {!r}".format(w, b)
+        if x_min is None or x_max is None:
+            raise SystemExit("--linear needs --x-min and --x-max")
+    else:
+        f, x_min, x_max, description = diabetes_model(args.model, args.degree)
+        x_min = x_min if args.x_min is None else args.x_min
+        x_max = x_max if args.x_max is None else args.x_max
+    if args.sigmoid:
+        model_f = f
+        f = lambda xs: [sigmoid(y) for y in model_f(xs)]
+        description = "sigmoid of " + description
+
+    x_min_q, seg_shift, table, err = build_lut(f, x_min, x_max, args.in_frac_bits, args.out_frac_bits,
+        args.max_error, args.max_entries)
+    if err > args.max_error:
+        print("Warning: error {:.6g} above bound with {} entries".format(err, len(table)))
+    path = "{}.h".format(args.name)
+    with open(path, "w") as fh:
+        fh.write(generate_header(args.name, x_min_q, seg_shift, table, err,
+            args.in_frac_bits, args.out_frac_bits, description))
+    print("{} entries, segment 2^{}, max error {:.6g} -> {}".format(len(table), seg_shift, err, path))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,37 @@
+#ifndef __LUT_KERNELS_H
+#define __LUT_KERNELS_H
+
+#include <stdint.h>
+
+// Lookup table with linear interpolation for bounded single-feature models
+//
+// The table samples the model at x_min + i * 2^seg_shift (i = 0..n_segments),
+// so finding the segment and the interpolation weight are a subtract, a
+// shift and a mask. Inputs outside the table are clamped to its ends.
+// Tables are generated by lut_codegen.py for any model form.
+struct lut_table {
+    int32_t x_min;          // Q(in_frac) input at y[0]
+    uint8_t seg_shift;      // log2 of the segment width in input units
+    uint16_t n_segments;    // y holds n_segments + 1 points
+    const int32_t *y;       // Q(out_frac) model outputs
+};
+
+static inline int32_t lut_interp(const struct lut_table *t, int32_t x) {
+    int32_t off = x - t->x_min;
+    uint32_t i, frac;
+    int32_t y0;
+
+    if (off <= 0)
+        return t->y[0];
+    i = (uint32_t)off >> t->seg_shift;
+    if (i >= t->n_segments)
+        return t->y[t->n_segments];
+    frac = (uint32_t)off & ((1u << t->seg_shift) - 1);
+    y0 = t->y[i];
+
+    return y0 + (int32_t)(((int64_t)(t->y[i + 1] - y0) * frac) >> t->seg_shift);
+}
+
+void lut_interp_batch(const struct lut_table *t, const int32_t *x, int32_t *y, unsigned n);
+
+#endif // __LUT_KERNELS_H
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+
+# Compressed firmware image for serial boot (make demo_lz4.bin)
+#
+# Serial boot time is set by the UART, so demo.bin is sent LZ4 compressed
+# and expanded on the target by the loader stub (loader.c), which runs from
+# SRAM, writes the image to the start of main_ram and jumps to _start.
+#
+# Layout (little endian):
+#   u32 magic        LZ4_IMAGE_MAGIC
+#   u32 size         decompressed bytes
+#   u32 packed_size  LZ4 block bytes
+#   u32 crc32        CRC-32 of the decompressed image
+#   LZ4 block (lz4.org block format, no frame)
+
+import argparse
+import struct
+import zlib
+
+LZ4_IMAGE_MAGIC = 0x4c345a4c # "LZ4L"
+
+MIN_MATCH     = 4
+MAX_OFFSET    = 0xffff
+LAST_LITERALS = 5            # block format: the last 5 bytes are literals
+MF_LIMIT      = 12           # and the last match starts 12 bytes before the end
+
+
+def _length(n):
+    """Extra length bytes after a 15 nibble."""
+    out = bytearray()
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+    return out
+
+
+def _sequence(out, literals, offset=None, match_len=0):
+    lit = len(literals)
+    ml = match_len - MIN_MATCH if offset is not None else 0
+    out.append((min(lit, 15) << 4) | min(ml, 15))
+    if lit >= 15:
+        out += _length(lit - 15)
+    out += literals
+    if offset is not None:
+        out += struct.pack("<H", offset)
+        if ml >= 15:
+            out += _length(ml - 15)
+
+
+def lz4_compress(data):
+    """Greedy LZ4 block compressor (most recent 4-byte match, no chains)."""
+    data = bytes(data)
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = i = 0
+    limit = n - MF_LIMIT
+    while i < limit:
+        key = data[i:i + MIN_MATCH]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > MAX_OFFSET:
+            i += 1
+            continue
+        m = MIN_MATCH
+        max_m = n - LAST_LITERALS - i
+        while m < max_m and data[cand + m] == data[i + m]:
+            m += 1
+        _sequence(out, data[anchor:i], i - cand, m)
+        for j in range(i + 1, min(i + m, limit)):
+            table[data[j:j + MIN_MATCH]] = j
+        i += m
+        anchor = i
+    _sequence(out, data[anchor:])
+    return bytes(out)
+
+
+def lz4_decompress(block, size):
+    """Reference decoder (same checks as loader.c)."""
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        token = block[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = block[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        out += block[i:i + lit]
+        i += lit
+        if i >= len(block):
+            break
+        offset = block[i] | (block[i + 1] << 8)
+        i += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("bad match offset {} at output {}".format(offset, len(out)))
+        ml = token & 15
+        if ml == 15:
+            while True:
+                b = block[i]
+                i += 1
+                ml += b
+                if b != 255:
+                    break
+        for _ in range(ml + MIN_MATCH):
+            out.append(out[-offset])
+    if len(out) != size:
+        raise ValueError("decompressed {} bytes, expected {}".format(len(out), size))
+    return bytes(out)
+
+
+def pack_image(data):
+    block = lz4_compress(data)
+    if lz4_decompress(block, len(data)) != data:
+        raise ValueError("LZ4 round trip failed")
+    header = struct.pack("<IIII", LZ4_IMAGE_MAGIC, len(data), len(block), zlib.crc32(data) & 0xffffffff)
+    return header + block
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack a firmware binary for the LZ4 loader stub.")
+    parser.add_argument("input",  help="Firmware binary (demo.bin).")
+    parser.add_argument("output", help="Compressed image (demo.lz4).")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    image = pack_image(data)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("{}: {} -> {} bytes ({:.0%})".format(args.output, len(data), len(image), len(image) / max(1, len(data))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,19 @@
+#ifndef __MAIN_RAM_H
+#define __MAIN_RAM_H
+
+#include <string.h>
+
+// Large, not speed-critical buffers (UART rings, protocol frames) go to
+// main_ram instead of the 8 KiB SRAM that also holds .data, .bss and the
+// stack. The section is NOLOAD, so it is cleared by main_ram_bss_init()
+// at the start of main() rather than by crt0.
+#define MAIN_RAM_BSS __attribute__((section(".main_ram_bss")))
+
+extern char _fmain_ram_bss[];
+extern char _emain_ram_bss[];
+
+static inline void main_ram_bss_init(void) {
+    memset(_fmain_ram_bss, 0, _emain_ram_bss - _fmain_ram_bss);
+}
+
+#endif // __MAIN_RAM_H
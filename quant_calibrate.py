@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+
+# Quantization calibration
+#
+# Trains (or loads) a model, sweeps fixed-point formats and reports the error
+# of the integer model against the float one. The narrowest format within the
+# accuracy budget is written to a JSON file read by fixed_codegen.py
+# ("cpu" section: weights and inputs are emitted as the narrowest C types
+# holding act_bits/weight_bits) and by the SoC scripts through --accel-format ("accel"
+# section, InferenceAccelerator data_width/frac_bits).
+
+import argparse
+import json
+
+import numpy as np
+
+from fixed_codegen import model_params, export, format_kwargs, c_int_type
+
+WIDTHS = [8, 10, 12, 14, 16, 20, 24, 32]
+
+# Models ---------------------------------------------------------------------------------------------
+
+def load_diabetes_model():
+    from sklearn.datasets import load_diabetes
+    from sklearn.model_selection import train_test_split
+    from sklearn.linear_model import LinearRegression
+    X, y = load_diabetes(return_X_y=True)
+    X = X[:, [2]] # Same single feature as lgr_microlgen.py
+    X_train, X_test, y_train, y_test = train_test_split(X, y, test_size=20, shuffle=False)
+    return LinearRegression().fit(X_train, y_train), X
+
+def load_digits_model():
+    from sklearn.datasets import load_digits
+    from sklearn.model_selection import train_test_split
+    from sklearn.linear_model import LogisticRegression
+    X, y = load_digits(return_X_y=True)
+    X_train, X_test, y_train, y_test = train_test_split(X, y, test_size=0.25, random_state=42)
+    clf = LogisticRegression(multi_class="multinomial", solver="lbfgs", max_iter=500)
+    return clf.fit(X_train, y_train), X
+
+def load_pickled_model(model_path, data_path):
+    import joblib
+    return joblib.load(model_path), np.load(data_path)
+
+# Fixed-point simulation -----------------------------------------------------------------------------
+
+def fits(q, bits):
+    return q.size == 0 or (q.min() >= -(1 << (bits - 1)) and q.max() <= (1 << (bits - 1)) - 1)
+
+def to_fixed(v, frac_bits):
+    return np.round(np.asarray(v, dtype=np.float64) * (1 << frac_bits)).astype(np.int64)
+
+def wrap(v, bits):
+    """Two's complement wrap-around to `bits` (what a hardware register does)."""
+    v = v & ((1 << bits) - 1)
+    return np.where(v >= (1 << (bits - 1)), v - (1 << bits), v)
+
+def simulate_cpu(weights, biases, X, act_bits, in_frac, weight_bits, w_frac, out_frac):
+    """Scores as computed by fixed_codegen.py headers, or None if the format overflows."""
+    xq = to_fixed(X, in_frac)
+    wq = to_fixed(weights, w_frac)
+    bq = to_fixed(biases, out_frac)
+    if not (fits(xq, act_bits) and fits(wq, weight_bits) and fits(bq, 32)):
+        return None
+    shift = in_frac + w_frac - out_frac
+    acc = xq @ wq.T
+    if shift:
+        acc = (acc + (1 << (shift - 1))) >> shift
+    scores = acc + bq
+    if not fits(scores, 32):
+        return None
+    return scores / float(1 << out_frac)
+
+def simulate_accel(weight, bias, x, data_width, frac_bits):
+    """InferenceAccelerator: ((x * w) >> frac) + b, truncating shift, data_width registers."""
+    xq, wq, bq = to_fixed(x, frac_bits), to_fixed(weight, frac_bits), to_fixed(bias, frac_bits)
+    if not (fits(xq, data_width) and fits(np.atleast_1d(wq), data_width) and fits(np.atleast_1d(bq), data_width)):
+        return None
+    y = ((xq * wq) >> frac_bits) + bq
+    if not fits(y, data_width):
+        return None
+    return wrap(y, data_width) / float(1 << frac_bits)
+
+# Error metrics --------------------------------------------------------------------------------------
+
+def error(ref_scores, scores, is_classifier):
+    """Regression: max abs error. Classifier: fraction of changed predictions."""
+    if is_classifier:
+        if scores.shape[1] == 1:
+            return float(np.mean((ref_scores[:, 0] > 0) != (scores[:, 0] > 0)))
+        return float(np.mean(ref_scores.argmax(axis=1) != scores.argmax(axis=1)))
+    return float(np.max(np.abs(ref_scores - scores)))
+
+# Sweeps ---------------------------------------------------------------------------------------------
+
+def sweep_cpu(model, X, budget, verbose):
+    weights, biases, is_classifier = model_params(model)
+    ref = X @ weights.T + biases
+    # Integer-valued inputs (digits pixels) need no fractional bits
+    integer_inputs = np.all(np.asarray(X) == np.round(X))
+    in_fracs = [0] if integer_inputs else None
+    results = []
+    for act_bits in WIDTHS:
+        for weight_bits in WIDTHS:
+            for in_frac in (in_fracs or range(act_bits)):
+                for w_frac in range(weight_bits):
+                    out_frac = min(16, in_frac + w_frac)
+                    scores = simulate_cpu(weights, biases, X, act_bits, in_frac, weight_bits, w_frac, out_frac)
+                    if scores is None:
+                        continue
+                    err = error(ref, scores, is_classifier)
+                    results.append(dict(act_bits=act_bits, in_frac_bits=in_frac,
+                        weight_bits=weight_bits, w_frac_bits=w_frac, out_frac_bits=out_frac, error=err))
+    ok = [r for r in results if r["error"] <= budget]
+    if verbose:
+        report(results, ["act_bits", "weight_bits"], ["act_bits", "in_frac_bits", "weight_bits", "w_frac_bits"])
+    if not ok:
+        return None
+    return min(ok, key=lambda r: (r["act_bits"] + r["weight_bits"], r["error"]))
+
+def sweep_accel(model, X, budget, verbose):
+    weights, biases, is_classifier = model_params(model)
+    if is_classifier or weights.shape != (1, 1):
+        return None
+    x = np.asarray(X)[:, 0]
+    ref = x * weights[0, 0] + biases[0]
+    results = []
+    for data_width in WIDTHS:
+        for frac_bits in range(data_width):
+            y = simulate_accel(weights[0, 0], biases[0], x, data_width, frac_bits)
+            if y is None:
+                continue
+            results.append(dict(data_width=data_width, frac_bits=frac_bits, error=error(ref, y, False)))
+    ok = [r for r in results if r["error"] <= budget]
+    if verbose:
+        report(results, ["data_width"], ["data_width", "frac_bits"])
+    if not ok:
+        return None
+    return min(ok, key=lambda r: (r["data_width"], r["error"]))
+
+def report(results, widths, keys):
+    # Best error per width combination
+    best = {}
+    for r in results:
+        k = tuple(r[w] for w in widths)
+        if k not in best or r["error"] < best[k]["error"]:
+            best[k] = r
+    for k in sorted(best):
+        r = best[k]
+        print("  " + " ".join("{}={:<3}".format(key, r[key]) for key in keys) + " error={:.6g}".format(r["error"]))
+
+# Main -----------------------------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="Pick the narrowest fixed-point format within an accuracy budget.")
+    parser.add_argument("--model",      default="diabetes", choices=["diabetes", "digits"], help="Built-in model to train.")
+    parser.add_argument("--model-file", default=None,  help="joblib-pickled sklearn model (overrides --model).")
+    parser.add_argument("--data-file",  default=None,  help="Calibration inputs (.npy) for --model-file.")
+    parser.add_argument("--budget",     default=None,  type=float,
+        help="Max abs output error (regression, default 0.5) or fraction of changed predictions (classifier, default 0.005).")
+    parser.add_argument("--output",     default="quant_format.json", help="Format file for fixed_codegen.py/--accel-format.")
+    parser.add_argument("--export",     default=None,  help="Also export the model header with the chosen format under this name.")
+    parser.add_argument("--verbose",    action="store_true", help="Print best error for every width combination.")
+    args = parser.parse_args()
+    if args.model_file and not args.data_file:
+        parser.error("--model-file needs --data-file")
+
+    if args.model_file:
+        model, X = load_pickled_model(args.model_file, args.data_file)
+    elif args.model == "digits":
+        model, X = load_digits_model()
+    else:
+        model, X = load_diabetes_model()
+
+    is_classifier = hasattr(model, "classes_")
+    budget = args.budget if args.budget is not None else (0.005 if is_classifier else 0.5)
+    print("Calibrating {} on {} samples, budget {}".format(type(model).__name__, len(X), budget))
+
+    fmt = {"budget": budget}
+    cpu = sweep_cpu(model, X, budget, args.verbose)
+    if cpu is None:
+        raise SystemExit("No CPU format meets the budget")
+    fmt["cpu"] = cpu
+    print("CPU format:   inputs {act_bits}b Q.{in_frac_bits}, weights {weight_bits}b Q.{w_frac_bits}, "
+          "outputs Q.{out_frac_bits}, error {error:.6g}".format(**cpu))
+    print("CPU types:    inputs {}, weights {}".format(c_int_type(cpu["act_bits"]), c_int_type(cpu["weight_bits"])))
+
+    accel = sweep_accel(model, X, budget, args.verbose)
+    if accel is not None:
+        fmt["accel"] = accel
+        print("Accel format: data_width {data_width}, frac_bits {frac_bits}, error {error:.6g}".format(**accel))
+
+    with open(args.output, "w") as f:
+        json.dump(fmt, f, indent=2)
+    print("Format written to {}".format(args.output))
+
+    if args.export:
+        export(model, args.export, blob_path="{}.bin".format(args.export) if accel else None,
+            **format_kwargs(fmt))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,53 @@
+#include <stdio.h>
+
+#include "sched.h"
+
+static struct sched_task tasks[SCHED_MAX_TASKS];
+static unsigned n_tasks;
+static uint32_t idle_passes;
+
+int sched_add(const char *name, sched_task_fn run, void *ctx) {
+    if (n_tasks == SCHED_MAX_TASKS)
+        return -1;
+
+    tasks[n_tasks].name = name;
+    tasks[n_tasks].run = run;
+    tasks[n_tasks].ctx = ctx;
+    tasks[n_tasks].calls = 0;
+    tasks[n_tasks].busy = 0;
+    return n_tasks++;
+}
+
+int sched_run_once(void) {
+    int work = 0;
+    unsigned i;
+
+    for (i = 0; i < n_tasks; i++) {
+        tasks[i].calls++;
+        if (tasks[i].run(tasks[i].ctx)) {
+            tasks[i].busy++;
+            work = 1;
+        }
+    }
+
+    if (!work)
+        idle_passes++;
+    return work;
+}
+
+void sched_loop(void) {
+    while (1) {
+        sched_run_once();
+    }
+}
+
+void sched_report(void) {
+    unsigned i;
+
+    printf("%-12s %10s %10s\n", "task", "calls", "busy");
+    for (i = 0; i < n_tasks; i++) {
+        printf("%-12s %10lu %10lu\n", tasks[i].name,
+               (unsigned long)tasks[i].calls, (unsigned long)tasks[i].busy);
+    }
+    printf("%-12s %10lu\n", "idle passes", (unsigned long)idle_passes);
+}
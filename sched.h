@@ -0,0 +1,32 @@
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#include <stdint.h>
+
+// Cooperative run-to-yield scheduler
+//
+// Tasks are plain functions called round-robin from main(). Each call does a
+// bounded slice of work (keeping its progress in its own state) and returns
+// nonzero when it did something, zero when it had nothing to do. No stacks,
+// no preemption: a task that blocks stalls every other task.
+
+#define SCHED_MAX_TASKS 8
+
+typedef int (*sched_task_fn)(void *ctx);
+
+struct sched_task {
+    const char *name;
+    sched_task_fn run;
+    void *ctx;
+    uint32_t calls;
+    uint32_t busy;              // calls that did some work
+};
+
+int sched_add(const char *name, sched_task_fn run, void *ctx);
+// One pass over all tasks, returns nonzero if any task did work
+int sched_run_once(void);
+void sched_loop(void);
+// Task table with call/busy counts (console `tasks` command)
+void sched_report(void);
+
+#endif // __SCHED_H
@@ -22,11 +22,11 @@ from litex.soc.cores.video import *
 
 from litex.soc.cores.hyperbus import HyperRAM
 
-from inference_accelerator import InferenceAccelerator
+from inference_accelerator import add_inference_accelerator
 # CRG ----------------------------------------------------------------------------------------------
 
 class _CRG(LiteXModule):
-    def __init__(self, platform, sys_clk_freq, with_video_pll=False):
+    def __init__(self, platform, sys_clk_freq, with_video_pll=False, with_sys_ps=False):
         self.rst    = Signal()
         self.cd_sys = ClockDomain()
 
@@ -41,6 +41,10 @@ class _CRG(LiteXModule):
         self.comb += pll.reset.eq(~rst_n)
         pll.register_clkin(clk27, 27e6)
         pll.create_clkout(self.cd_sys, sys_clk_freq)
+        if with_sys_ps:
+            # HyperRAM clock at sys_clk (clk_ratio="1:1")
+            self.cd_sys_ps = ClockDomain()
+            pll.create_clkout(self.cd_sys_ps, sys_clk_freq, phase=90)
 
         # Video PLL
         if with_video_pll:
@@ -61,29 +65,49 @@ class _CRG(LiteXModule):
 
 class BaseSoC(SoCCore):
     def __init__(self, toolchain="gowin", sys_clk_freq=27e6, bios_flash_offset=0x0,
+        data_flash_offset   = 0x100000,
+        boot_flash_offset   = 0x80000,
         with_led_chaser     = True,
         with_video_terminal = False,
+        accel_format        = None,
+        accel_degree        = 1,
+        hyperram_mode       = "single",
+        hyperram_clk_ratio  = "4:1",
+        hyperram_config     = False,
+        hyperram_read_cal   = None,
         **kwargs):
         platform = sipeed_tang_nano_9k.Platform(toolchain=toolchain)
 
         # CRG --------------------------------------------------------------------------------------
-        self.crg = _CRG(platform, sys_clk_freq, with_video_pll=with_video_terminal)
+        self.crg = _CRG(platform, sys_clk_freq, with_video_pll=with_video_terminal, with_sys_ps=(hyperram_clk_ratio == "1:1"))
 
         # SoCCore ----------------------------------------------------------------------------------
         # Disable Integrated ROM
         kwargs["integrated_rom_size"] = 128*1024
+        # Cycles since reset, for the firmware's power-on to first inference time
+        kwargs["timer_uptime"] = True
         SoCCore.__init__(self, platform, sys_clk_freq, ident="LiteX SoC on Tang Nano 9K", **kwargs)
 
         # SPI Flash --------------------------------------------------------------------------------
         from litespi.modules import W25Q32
         from litespi.opcodes import SpiNorFlashOpCodes as Codes
         self.add_spi_flash(mode="1x", module=W25Q32(Codes.READ_1_1_1), with_master=False)
+        # Datasets/model blobs packed by flash_pack.py, streamed by flash_data.c
+        self.add_constant("FLASH_DATA_OFFSET", data_flash_offset)
+        # Firmware (make demo.fbi): the BIOS copies it to main_ram and boots it
+        # when no serial boot is requested
+        self.add_constant("FLASH_BOOT_ADDRESS", self.bus.regions["spiflash"].origin + boot_flash_offset)
 
         self.cpu.set_reset_address(self.bus.regions["rom"].origin)
 
         # HyperRAM ---------------------------------------------------------------------------------
         if not self.integrated_main_ram_size:
-            # TODO: Use second 32Mbit PSRAM chip.
+            # Two 32Mbit PSRAM dies, each with its own DQ/RWDS/CS#/CK:
+            # - single:      die 0 only, 4MB.
+            # - interleaved: both dies as one 16-bit memory (one byte of each beat per die), 8MB.
+            # - contiguous:  die 0 then die 1, 8MB.
+            assert hyperram_mode in ["single", "interleaved", "contiguous"]
+            dies    = 1 if hyperram_mode == "single" else 2
             dq      = platform.request("IO_psram_dq")
             rwds    = platform.request("IO_psram_rwds")
             reset_n = platform.request("O_psram_reset_n")
@@ -91,26 +115,41 @@ class BaseSoC(SoCCore):
             ck      = platform.request("O_psram_ck")
             ck_n    = platform.request("O_psram_ck_n")
             class HyperRAMPads:
-                def __init__(self, n):
-                    self.clk   = Signal()
-                    self.rst_n = reset_n[n]
-                    self.dq    = dq[8*n:8*(n+1)]
-                    self.cs_n  = cs_n[n]
-                    self.rwds  = rwds[n]
-
-            hyperram_pads = HyperRAMPads(0)
-            self.comb += ck[0].eq(hyperram_pads.clk)
-            self.comb += ck_n[0].eq(~hyperram_pads.clk)
+                def __init__(self, dies):
+                    self.rst_n = reset_n[:dies]
+                    self.dq    = dq[:8*dies]
+                    self.cs_n  = cs_n[:dies]
+                    self.rwds  = rwds[:dies]
+
+            hyperram_pads = HyperRAMPads(dies)
+            if hyperram_clk_ratio == "4:1":
+                hyperram_pads.clk = Signal()
+                for n in range(dies):
+                    self.comb += ck[n].eq(hyperram_pads.clk)
+                    self.comb += ck_n[n].eq(~hyperram_pads.clk)
+            else:
+                # DDR PHY (experimental): CK/CK# driven by ODDRs, read capture point from
+                # hyperram_calibrate.py (--hyperram-read-cal)
+                hyperram_pads.clk_p = ck[:dies]
+                hyperram_pads.clk_n = ck_n[:dies]
             # FIXME: Issue with upstream HyperRAM core, so use old one. Need to investigate.
             if not os.path.exists("hyperbus.py"):
                 os.system("wget https://github.com/litex-hub/litex-boards/files/8831568/hyperbus.py.txt")
                 os.system("mv hyperbus.py.txt hyperbus.py")
             from hyperbus import HyperRAM
-            self.hyperram = HyperRAM(hyperram_pads)
-            self.bus.add_slave("main_ram", slave=self.hyperram.bus, region=SoCRegion(origin=self.mem_map["main_ram"], size=4 * MEGABYTE, mode="rwx"))
+            # With hyperram_config, CR0 is programmed at power-up for the lowest latency at the
+            # HyperBus clock (sys_clk_freq/4 by default, variable except when interleaved), else the
+            # chip keeps its defaults (6 clocks, fixed). Bursts are the longest (up to a cache line)
+            # that keep CS low within tCSM (4us) at that latency.
+            self.hyperram = HyperRAM(hyperram_pads, burst_words=None, with_config=hyperram_config, with_csr=True, sys_clk_freq=sys_clk_freq,
+                dual_die  = None if hyperram_mode == "single" else hyperram_mode,
+                die_size  = 4 * MEGABYTE,
+                clk_ratio = hyperram_clk_ratio,
+                read_cal  = hyperram_read_cal)
+            self.bus.add_slave("main_ram", slave=self.hyperram.bus, region=SoCRegion(origin=self.mem_map["main_ram"], size=dies * 4 * MEGABYTE, mode="rwx"))
 
         # Instantiate the accelerator peripheral
-        self.inference_accel = InferenceAccelerator()
+        add_inference_accelerator(self, accel_format, max_degree=accel_degree)
 
         # Video ------------------------------------------------------------------------------------
         if with_video_terminal:
@@ -135,16 +174,36 @@ def main():
     parser.add_target_argument("--flash",                action="store_true",      help="Flash Bitstream.")
     parser.add_target_argument("--sys-clk-freq",         default=27e6, type=float, help="System clock frequency.")
     parser.add_target_argument("--bios-flash-offset",    default="0x0",            help="BIOS offset in SPI Flash.")
+    parser.add_target_argument("--data-flash-offset",    default="0x100000",       help="Data image offset in SPI Flash.")
+    parser.add_target_argument("--data-image",           default=None,             help="Data image (from flash_pack.py) to flash with --flash.")
+    parser.add_target_argument("--boot-flash-offset",    default="0x80000",        help="Firmware boot image offset in SPI Flash.")
+    parser.add_target_argument("--boot-image",           default=None,             help="Firmware boot image (make demo.fbi) to flash with --flash.")
     parser.add_target_argument("--with-spi-sdcard",      action="store_true",      help="Enable SPI-mode SDCard support.")
     parser.add_target_argument("--with-video-terminal",  action="store_true",      help="Enable Video Terminal (HDMI).")
     parser.add_target_argument("--prog-kit",             default="openfpgaloader", help="Programmer select from Gowin/openFPGALoader.")
+    parser.add_target_argument("--accel-format",         default=None,             help="Accelerator fixed-point format file (from quant_calibrate.py).")
+    parser.add_target_argument("--accel-degree",         default=1, type=int,      help="Highest polynomial degree supported by the accelerator.")
+    parser.add_target_argument("--hyperram-mode",        default="single",         help="PSRAM dies: single (4MB), interleaved (16-bit, 8MB) or contiguous (8MB).",
+        choices=["single", "interleaved", "contiguous"])
+    parser.add_target_argument("--hyperram-clk-ratio",   default="4:1",            help="sys_clk to HyperBus clock ratio (2:1 and 1:1: experimental DDR I/Os, see --hyperram-read-cal).",
+        choices=["4:1", "2:1", "1:1"])
+    parser.add_target_argument("--hyperram-read-cal",    default=None, type=int,   help="DDR read capture point measured by hyperram_calibrate.py (default: unmeasured guess).")
+    parser.add_target_argument("--hyperram-config",      action="store_true",      help="Program the HyperRAM latency/burst configuration (CR0) at power-up.")
     args = parser.parse_args()
 
     soc = BaseSoC(
         toolchain           = args.toolchain,
         sys_clk_freq        = args.sys_clk_freq,
         bios_flash_offset   = int(args.bios_flash_offset, 0),
+        data_flash_offset   = int(args.data_flash_offset, 0),
+        boot_flash_offset   = int(args.boot_flash_offset, 0),
         with_video_terminal = args.with_video_terminal,
+        accel_format        = args.accel_format,
+        accel_degree        = args.accel_degree,
+        hyperram_mode       = args.hyperram_mode,
+        hyperram_clk_ratio  = args.hyperram_clk_ratio,
+        hyperram_config     = args.hyperram_config,
+        hyperram_read_cal   = args.hyperram_read_cal,
         **parser.soc_argdict
     )
 
@@ -166,6 +225,10 @@ def main():
         # if needed, use openFPGALoader or Gowin programmer GUI
         if args.prog_kit == "openfpgaloader":
             prog.flash(int(args.bios_flash_offset, 0), builder.get_bios_filename(), external=True)
+            if args.data_image is not None:
+                prog.flash(int(args.data_flash_offset, 0), args.data_image, external=True)
+            if args.boot_image is not None:
+                prog.flash(int(args.boot_flash_offset, 0), args.boot_image, external=True)
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,429 @@
+#include <string.h>
+#include <generated/csr.h>
+#include <libbase/crc.h>
+
+#include "inference_accel.h"
+#include "uart_ring.h"
+#include "accel_model.h"
+#include "main_ram.h"
+#include "uart_proto.h"
+
+#ifdef INFERENCE_ACCEL_DATA_WIDTH
+#define UART_PROTO_DATA_WIDTH   INFERENCE_ACCEL_DATA_WIDTH
+#define UART_PROTO_SAMPLE_BYTES ((INFERENCE_ACCEL_DATA_WIDTH + 7) / 8)
+#define UART_PROTO_FRAC_BITS    INFERENCE_ACCEL_FRAC_BITS
+#define UART_PROTO_MAX_DEGREE   INFERENCE_ACCEL_MAX_DEGREE
+#else
+#define UART_PROTO_DATA_WIDTH   32
+#define UART_PROTO_SAMPLE_BYTES 4
+#define UART_PROTO_FRAC_BITS    0
+#define UART_PROTO_MAX_DEGREE   0
+#endif
+#define UART_PROTO_MAX_SAMPLES  (UART_PROTO_MAX_PAYLOAD / UART_PROTO_SAMPLE_BYTES)
+
+// Zig-zag difference of two data width values: data width + 1 bits, 7 per varint byte
+#define UART_PROTO_VARINT_MAX   ((UART_PROTO_DATA_WIDTH + 7) / 7)
+#define UART_PROTO_DELTA_MAX    (UART_PROTO_MAX_SAMPLES * UART_PROTO_VARINT_MAX)
+#define UART_PROTO_MAX_REPLY    (UART_PROTO_DELTA_MAX > UART_PROTO_MAX_PAYLOAD ? \
+                                 UART_PROTO_DELTA_MAX : UART_PROTO_MAX_PAYLOAD)
+
+#define UART_PROTO_FRAME_LEN    (UART_PROTO_HEADER_LEN + UART_PROTO_MAX_REPLY + UART_PROTO_CRC_LEN)
+
+// Bytes parsed / samples run per task call
+#define INGEST_BUDGET           256
+#define SINGLE_BUDGET           64
+
+enum {
+    SLOT_FREE,                  // (being) filled by ingest
+    SLOT_READY,                 // complete frame, waiting for dispatch
+    SLOT_RUNNING,               // INFER samples in the accelerator
+    SLOT_DONE,                  // reply built in place, waiting for egress
+};
+
+struct proto_slot {
+    uint8_t frame[UART_PROTO_FRAME_LEN];
+    int state;
+    uint8_t error;              // set by ingest for frames it could not receive
+    unsigned len;               // reply bytes
+    unsigned sent;
+    unsigned n;                 // INFER samples
+    unsigned next_in;           // samples handed to the accelerator
+    unsigned next_out;          // results written back
+};
+
+static struct proto_slot slots[UART_PROTO_SLOTS] MAIN_RAM_BSS;
+static unsigned ingest_slot, dispatch_slot, egress_slot;
+static unsigned fill, need;     // ingest progress in slots[ingest_slot]
+static int active, exiting;
+
+// Session result encoding (ENCODING frame)
+static uint8_t encoding;
+static unsigned drop_bits;      // fraction bits truncated from each result
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+// Sign-extending load/store of one packed sample
+static inline int32_t sample_load(const uint8_t *p) {
+    uint32_t v = 0;
+    int i;
+
+    for (i = UART_PROTO_SAMPLE_BYTES - 1; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+#if UART_PROTO_SAMPLE_BYTES < 4
+    return (int32_t)(v << (32 - 8 * UART_PROTO_SAMPLE_BYTES)) >> (32 - 8 * UART_PROTO_SAMPLE_BYTES);
+#else
+    return (int32_t)v;
+#endif
+}
+
+static inline void sample_store(uint8_t *p, int32_t v) {
+    int i;
+
+    for (i = 0; i < UART_PROTO_SAMPLE_BYTES; i++) {
+        p[i] = (uint32_t)v >> (8 * i);
+    }
+}
+
+// Header and CRC of the reply whose payload is already in the slot
+static void finish_reply(struct proto_slot *sl, uint8_t type, unsigned length) {
+    unsigned n = UART_PROTO_HEADER_LEN + length;
+
+    sl->frame[0] = UART_PROTO_SYNC;
+    sl->frame[1] = type;
+    sl->frame[3] = 0;           // frame[2] still holds the request seq
+    put_u16(&sl->frame[4], length);
+    put_u16(&sl->frame[n], crc16(&sl->frame[1], n - 1));
+    sl->len = n + UART_PROTO_CRC_LEN;
+    sl->sent = 0;
+    sl->state = SLOT_DONE;
+}
+
+static inline unsigned fixed_result_bytes(void) {
+    return (UART_PROTO_DATA_WIDTH - drop_bits + 7) / 8;
+}
+
+// Re-encode the sample-packed results of an INFER slot, returns the payload length
+static unsigned encode_results(struct proto_slot *sl) {
+    uint8_t *payload = &sl->frame[UART_PROTO_HEADER_LEN];
+    unsigned i, b, len = 0, bytes = fixed_result_bytes();
+    uint8_t *src;
+    int32_t v, prev = 0;
+    uint32_t z;
+
+    if (encoding == UART_PROTO_ENC_FIXED) {
+        if (drop_bits == 0)
+            return sl->n * UART_PROTO_SAMPLE_BYTES;
+        // Never longer than the samples, so it is done in place front to back
+        for (i = 0; i < sl->n; i++) {
+            v = sample_load(&payload[i * UART_PROTO_SAMPLE_BYTES]) >> drop_bits;
+            for (b = 0; b < bytes; b++) {
+                payload[len++] = (uint32_t)v >> (8 * b);
+            }
+        }
+        return len;
+    }
+
+    // Varints can outgrow the samples: move the samples to the end of the
+    // slot first, the encoder then never catches up with them
+    src = payload + UART_PROTO_MAX_REPLY - sl->n * UART_PROTO_SAMPLE_BYTES;
+    memmove(src, payload, sl->n * UART_PROTO_SAMPLE_BYTES);
+    for (i = 0; i < sl->n; i++) {
+        v = sample_load(&src[i * UART_PROTO_SAMPLE_BYTES]) >> drop_bits;
+        z = (uint32_t)v - (uint32_t)prev;
+        prev = v;
+        z = (z << 1) ^ (uint32_t)((int32_t)z >> 31);
+        while (z >= 0x80) {
+            payload[len++] = z | 0x80;
+            z >>= 7;
+        }
+        payload[len++] = z;
+    }
+    return len;
+}
+
+static void finish_error(struct proto_slot *sl, uint8_t code, uint8_t detail) {
+    sl->frame[UART_PROTO_HEADER_LEN] = code;
+    sl->frame[UART_PROTO_HEADER_LEN + 1] = detail;
+    finish_reply(sl, UART_PROTO_ERROR, detail ? 2 : 1);
+}
+
+/*-----------------------------------------------------------------------*/
+/* Accelerator                                                           */
+/*-----------------------------------------------------------------------*/
+
+#ifdef CSR_INFERENCE_ACCEL_BASE
+#ifdef INFERENCE_ACCEL_MEM_BASE
+
+// One bank runs while the other is staged with the next batch
+static struct {
+    unsigned first[2], count[2];    // count 0: bank empty
+    int running;                    // bank in the accelerator, -1 when idle
+} banks = { { 0, 0 }, { 0, 0 }, -1 };
+
+static void bank_fill(struct proto_slot *sl, unsigned bank) {
+    volatile int32_t *in = inference_accel_batch_inputs(bank);
+    unsigned i, count = sl->n - sl->next_in;
+
+    if (count > INFERENCE_ACCEL_BATCH_DEPTH)
+        count = INFERENCE_ACCEL_BATCH_DEPTH;
+    for (i = 0; i < count; i++) {
+        in[i] = sample_load(&sl->frame[UART_PROTO_HEADER_LEN + (sl->next_in + i) * UART_PROTO_SAMPLE_BYTES]);
+    }
+    banks.first[bank] = sl->next_in;
+    banks.count[bank] = count;
+    sl->next_in += count;
+}
+
+static void bank_collect(struct proto_slot *sl, unsigned bank) {
+    volatile int32_t *out = inference_accel_batch_results(bank);
+    unsigned i;
+
+    for (i = 0; i < banks.count[bank]; i++) {
+        sample_store(&sl->frame[UART_PROTO_HEADER_LEN + (banks.first[bank] + i) * UART_PROTO_SAMPLE_BYTES],
+                     inference_accel_sign_extend(out[i]));
+    }
+    sl->next_out += banks.count[bank];
+    banks.count[bank] = 0;
+}
+
+// Advance the INFER job without waiting, returns nonzero if anything moved
+static int infer_step(struct proto_slot *sl) {
+    int work = 0, bank;
+
+    if (banks.running >= 0 && inference_accel_batch_is_done()) {
+        bank_collect(sl, banks.running);
+        banks.running = -1;
+        work = 1;
+    }
+    // Start the staged bank the moment the accelerator is idle
+    for (bank = 0; bank < 2 && banks.running < 0; bank++) {
+        if (banks.count[bank]) {
+            inference_accel_batch_start(bank, banks.count[bank]);
+            banks.running = bank;
+            work = 1;
+        }
+    }
+    // Stage the next batch while the current one runs
+    if (sl->next_in < sl->n) {
+        for (bank = 0; bank < 2; bank++) {
+            if (!banks.count[bank]) {
+                bank_fill(sl, bank);
+                if (banks.running < 0) {
+                    inference_accel_batch_start(bank, banks.count[bank]);
+                    banks.running = bank;
+                }
+                work = 1;
+                break;
+            }
+        }
+    }
+
+    return work;
+}
+
+#else
+
+static int infer_step(struct proto_slot *sl) {
+    uint8_t *p;
+    unsigned i;
+
+    for (i = 0; i < SINGLE_BUDGET && sl->next_out < sl->n; i++) {
+        p = &sl->frame[UART_PROTO_HEADER_LEN + sl->next_out * UART_PROTO_SAMPLE_BYTES];
+        sample_store(p, inference_accel_compute_fixed(sample_load(p)));
+        sl->next_out++;
+    }
+    sl->next_in = sl->next_out;
+    return 1;
+}
+
+#endif // INFERENCE_ACCEL_MEM_BASE
+#endif // CSR_INFERENCE_ACCEL_BASE
+
+/*-----------------------------------------------------------------------*/
+/* Frames                                                                */
+/*-----------------------------------------------------------------------*/
+
+static void handle_frame(struct proto_slot *sl) {
+    uint8_t type = sl->frame[1];
+    unsigned length = get_u16(&sl->frame[4]);
+    uint8_t *payload = &sl->frame[UART_PROTO_HEADER_LEN];
+    int err;
+
+    if (sl->error) {
+        finish_error(sl, sl->error, 0);
+        return;
+    }
+    if (get_u16(&payload[length]) != crc16(&sl->frame[1], UART_PROTO_HEADER_LEN - 1 + length)) {
+        finish_error(sl, UART_PROTO_ERR_CRC, 0);
+        return;
+    }
+
+    switch (type) {
+        case UART_PROTO_INFO:
+            payload[0] = UART_PROTO_VERSION;
+            payload[1] = UART_PROTO_SAMPLE_BYTES;
+            payload[2] = UART_PROTO_FRAC_BITS;
+            payload[3] = UART_PROTO_MAX_DEGREE;
+            put_u16(&payload[4], UART_PROTO_MAX_SAMPLES);
+            payload[6] = UART_PROTO_DATA_WIDTH;
+            finish_reply(sl, type | UART_PROTO_REPLY, 7);
+            break;
+        case UART_PROTO_INFER:
+#ifdef CSR_INFERENCE_ACCEL_BASE
+            if (length % UART_PROTO_SAMPLE_BYTES) {
+                finish_error(sl, UART_PROTO_ERR_LENGTH, 0);
+            } else {
+                sl->n = length / UART_PROTO_SAMPLE_BYTES;
+                sl->next_in = 0;
+                sl->next_out = 0;
+                sl->state = SLOT_RUNNING;
+            }
+#else
+            finish_error(sl, UART_PROTO_ERR_NO_ACCEL, 0);
+#endif
+            break;
+        case UART_PROTO_LOAD_MODEL:
+            if ((err = accel_model_load(payload, length)) != 0) {
+                finish_error(sl, UART_PROTO_ERR_MODEL, -err);
+            } else {
+                finish_reply(sl, type | UART_PROTO_REPLY, 0);
+            }
+            break;
+        case UART_PROTO_ENCODING:
+            if (length != 2) {
+                finish_error(sl, UART_PROTO_ERR_LENGTH, 0);
+            } else if (payload[0] > UART_PROTO_ENC_DELTA || payload[1] > UART_PROTO_FRAC_BITS) {
+                finish_error(sl, UART_PROTO_ERR_ENCODING, 0);
+            } else {
+                // Frames are dispatched in order: earlier INFER replies are already encoded
+                encoding = payload[0];
+                drop_bits = UART_PROTO_FRAC_BITS - payload[1];
+                payload[2] = fixed_result_bytes();
+                finish_reply(sl, type | UART_PROTO_REPLY, 3);
+            }
+            break;
+        case UART_PROTO_EXIT:
+            finish_reply(sl, type | UART_PROTO_REPLY, 0);
+            exiting = 1;
+            break;
+        default:
+            finish_error(sl, UART_PROTO_ERR_TYPE, 0);
+            break;
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/* Tasks                                                                 */
+/*-----------------------------------------------------------------------*/
+
+void uart_proto_start(void) {
+    unsigned i;
+
+    for (i = 0; i < UART_PROTO_SLOTS; i++) {
+        slots[i].state = SLOT_FREE;
+    }
+    ingest_slot = dispatch_slot = egress_slot = 0;
+    fill = 0;
+    need = UART_PROTO_HEADER_LEN;
+    exiting = 0;
+    encoding = UART_PROTO_ENC_FIXED;
+    drop_bits = 0;
+    active = 1;
+}
+
+int uart_proto_active(void) {
+    return active;
+}
+
+// Received bytes -> frame slots. Bytes stay in the UART ring while all slots are busy.
+int uart_proto_ingest_task(void *ctx) {
+    struct proto_slot *sl = &slots[ingest_slot];
+    unsigned budget = INGEST_BUDGET;
+    int c, work = 0;
+
+    while (active && !exiting && sl->state == SLOT_FREE && budget--) {
+        if ((c = uart_ring_getc_nonblock()) < 0)
+            break;
+        work = 1;
+
+        // Hunt for the sync byte between frames
+        if (fill == 0 && c != UART_PROTO_SYNC)
+            continue;
+        sl->frame[fill++] = c;
+        if (fill < need)
+            continue;
+
+        if (need == UART_PROTO_HEADER_LEN) {
+            unsigned length = get_u16(&sl->frame[4]);
+
+            sl->error = 0;
+            if (length <= UART_PROTO_MAX_PAYLOAD) {
+                need = UART_PROTO_HEADER_LEN + length + UART_PROTO_CRC_LEN;
+                continue;
+            }
+            sl->error = UART_PROTO_ERR_LENGTH;
+        }
+
+        sl->state = SLOT_READY;
+        ingest_slot = (ingest_slot + 1) % UART_PROTO_SLOTS;
+        sl = &slots[ingest_slot];
+        fill = 0;
+        need = UART_PROTO_HEADER_LEN;
+    }
+
+    return work;
+}
+
+int uart_proto_dispatch_task(void *ctx) {
+    struct proto_slot *sl = &slots[dispatch_slot];
+
+    if (sl->state == SLOT_READY) {
+        handle_frame(sl);
+        if (sl->state == SLOT_DONE)
+            dispatch_slot = (dispatch_slot + 1) % UART_PROTO_SLOTS;
+        return 1;
+    }
+
+#ifdef CSR_INFERENCE_ACCEL_BASE
+    if (sl->state == SLOT_RUNNING) {
+        int work = infer_step(sl);
+
+        if (sl->next_out == sl->n) {
+            finish_reply(sl, UART_PROTO_INFER | UART_PROTO_REPLY, encode_results(sl));
+            dispatch_slot = (dispatch_slot + 1) % UART_PROTO_SLOTS;
+        }
+        return work;
+    }
+#endif
+
+    return 0;
+}
+
+// Replies -> UART transmit ring, as much as fits
+int uart_proto_egress_task(void *ctx) {
+    struct proto_slot *sl = &slots[egress_slot];
+    unsigned n;
+
+    if (sl->state != SLOT_DONE)
+        return 0;
+
+    n = uart_ring_write_nonblock(&sl->frame[sl->sent], sl->len - sl->sent);
+    sl->sent += n;
+    if (sl->sent == sl->len) {
+        sl->state = SLOT_FREE;
+        egress_slot = (egress_slot + 1) % UART_PROTO_SLOTS;
+        // EXIT is the last frame handled, leave once its reply is queued
+        if (exiting && egress_slot == dispatch_slot)
+            active = 0;
+    }
+
+    return n != 0;
+}
@@ -0,0 +1,76 @@
+#ifndef __UART_PROTO_H
+#define __UART_PROTO_H
+
+#include <stdint.h>
+
+// Binary inference protocol, entered with the `binary` console command
+//
+// No echo and no printf while active: the host sends length-prefixed,
+// CRC-checked frames of packed fixed-point samples, the firmware runs them
+// through the accelerator and answers each frame with a frame of packed
+// results, so throughput is bounded by the UART rate.
+//
+// Frame (little endian):
+//   u8  sync     UART_PROTO_SYNC
+//   u8  type     UART_PROTO_*; replies set UART_PROTO_REPLY
+//   u8  seq      copied into the reply, lets the host keep frames in flight
+//   u8  flags    reserved, 0
+//   u16 length   payload bytes
+//   payload
+//   u16 crc      libbase crc16() (CRC-16/XMODEM) of type .. payload
+//
+// Samples are two's complement in the accelerator format, packed to the
+// accelerator data width rounded up to bytes (both reported by INFO).
+// Results use the session's encoding, set with an ENCODING frame and reset
+// to ENC_FIXED at full precision by the `binary` command:
+//   ENC_FIXED  results truncated to the requested fraction bits (arithmetic
+//              shift, i.e. floor), packed to the remaining width in bytes
+//   ENC_DELTA  the same truncated values as LEB128 varints of the zig-zag
+//              mapped difference to the previous result of the frame (the
+//              first one to 0); differences wrap modulo 2^32
+// Delta replies can exceed UART_PROTO_MAX_PAYLOAD, up to UART_PROTO_MAX_REPLY.
+
+#define UART_PROTO_SYNC          0xa5
+#define UART_PROTO_VERSION       2
+#define UART_PROTO_HEADER_LEN    6
+#define UART_PROTO_CRC_LEN       2
+#define UART_PROTO_MAX_PAYLOAD   1024
+
+// Frame types (host -> firmware)
+#define UART_PROTO_INFO          0x01 // -> u8 version, u8 sample bytes, u8 frac bits, u8 max degree,
+                                      //    u16 max samples, u8 data width
+#define UART_PROTO_INFER         0x02 // samples -> results
+#define UART_PROTO_EXIT          0x03 // back to the text console
+#define UART_PROTO_LOAD_MODEL    0x04 // accelerator model blob (accel_model.h) -> empty
+#define UART_PROTO_ENCODING      0x05 // u8 UART_PROTO_ENC_*, u8 frac bits to keep
+                                      // -> u8 encoding, u8 frac bits, u8 ENC_FIXED result bytes
+#define UART_PROTO_REPLY         0x80
+#define UART_PROTO_ERROR         0xff // -> u8 UART_PROTO_ERR_*, [u8 detail]
+
+#define UART_PROTO_ERR_CRC       1
+#define UART_PROTO_ERR_LENGTH    2
+#define UART_PROTO_ERR_TYPE      3
+#define UART_PROTO_ERR_NO_ACCEL  4
+#define UART_PROTO_ERR_MODEL     5    // followed by the negated ACCEL_MODEL_ERR_* code
+#define UART_PROTO_ERR_ENCODING  6    // unknown encoding or more frac bits than the accelerator
+
+#define UART_PROTO_ENC_FIXED     0
+#define UART_PROTO_ENC_DELTA     1
+
+// Frames are handled by three scheduler tasks (sched.h) through a FIFO of
+// UART_PROTO_SLOTS frame buffers: ingest parses received bytes into a free
+// slot, dispatch runs it (accelerator batches are started as soon as the
+// accelerator frees up, results overwrite the samples in place), egress
+// queues the reply on the UART and frees the slot. Replies keep the order
+// of the requests.
+#define UART_PROTO_SLOTS         2
+
+// Enter binary mode (the `binary` console command)
+void uart_proto_start(void);
+int uart_proto_active(void);
+
+int uart_proto_ingest_task(void *ctx);
+int uart_proto_dispatch_task(void *ctx);
+int uart_proto_egress_task(void *ctx);
+
+#endif // __UART_PROTO_H
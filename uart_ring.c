@@ -0,0 +1,169 @@
+#include <generated/csr.h>
+#include <generated/soc.h>
+#include <irq.h>
+#include <libbase/uart.h>
+
+#include "main_ram.h"
+#include "uart_ring.h"
+
+#define RX_MASK (UART_RING_RX_SIZE - 1)
+#define TX_MASK (UART_RING_TX_SIZE - 1)
+
+#if defined(CSR_UART_BASE) && defined(CONFIG_CPU_HAS_INTERRUPT) && !defined(UART_POLLING)
+
+// libbase/isr.c dispatch table
+extern int irq_attach(unsigned int irq, void (*isr)(void));
+
+static uint8_t rx_buf[UART_RING_RX_SIZE] MAIN_RAM_BSS;
+static volatile unsigned rx_produce;
+static volatile unsigned rx_consume;
+static volatile uint32_t rx_dropped;
+
+static uint8_t tx_buf[UART_RING_TX_SIZE] MAIN_RAM_BSS;
+static volatile unsigned tx_produce;
+static volatile unsigned tx_consume;
+
+static void rx_put(uint8_t c) {
+    unsigned next = (rx_produce + 1) & RX_MASK;
+
+    if (next == rx_consume) {
+        rx_dropped++;
+        return;
+    }
+    rx_buf[rx_produce] = c;
+    rx_produce = next;
+}
+
+// Move queued bytes into the UART FIFO (interrupts disabled or from the ISR)
+static void tx_pump(void) {
+    while (tx_consume != tx_produce && !uart_txfull_read()) {
+        uart_rxtx_write(tx_buf[tx_consume]);
+        tx_consume = (tx_consume + 1) & TX_MASK;
+    }
+}
+
+static void uart_ring_isr(void) {
+    // Drain the RX FIFO first (clearing the RX event pops one byte)
+    while (!uart_rxempty_read()) {
+        rx_put(uart_rxtx_read());
+        uart_ev_pending_write(UART_EV_RX);
+    }
+
+    // libbase acknowledges TX and sends queued printf output; bytes it
+    // received in the meantime arrived after ours and are appended in order
+    uart_isr();
+    while (uart_read_nonblock()) {
+        rx_put(uart_read());
+    }
+
+    tx_pump();
+}
+
+void uart_ring_init(void) {
+    unsigned ie = irq_getie();
+
+    irq_setie(0);
+    rx_produce = rx_consume = 0;
+    tx_produce = tx_consume = 0;
+    rx_dropped = 0;
+    irq_attach(UART_INTERRUPT, uart_ring_isr);
+    irq_setie(ie);
+}
+
+unsigned uart_ring_rx_available(void) {
+    return (rx_produce - rx_consume) & RX_MASK;
+}
+
+int uart_ring_getc_nonblock(void) {
+    uint8_t c;
+
+    if (rx_consume == rx_produce)
+        return -1;
+    c = rx_buf[rx_consume];
+    rx_consume = (rx_consume + 1) & RX_MASK;
+    return c;
+}
+
+uint32_t uart_ring_rx_dropped(void) {
+    return rx_dropped;
+}
+
+unsigned uart_ring_write_nonblock(const uint8_t *buf, unsigned len) {
+    unsigned ie = irq_getie();
+    unsigned n = 0, next;
+
+    irq_setie(0);
+    while (n < len) {
+        next = (tx_produce + 1) & TX_MASK;
+        if (next == tx_consume)
+            break;
+        tx_buf[tx_produce] = buf[n++];
+        tx_produce = next;
+    }
+    // The TX event only fires when the FIFO drains, so start it here
+    tx_pump();
+    irq_setie(ie);
+
+    return n;
+}
+
+unsigned uart_ring_tx_pending(void) {
+    return (tx_produce - tx_consume) & TX_MASK;
+}
+
+#else
+
+void uart_ring_init(void) {
+}
+
+unsigned uart_ring_rx_available(void) {
+    return uart_read_nonblock() ? 1 : 0;
+}
+
+int uart_ring_getc_nonblock(void) {
+    return uart_read_nonblock() ? (uint8_t)uart_read() : -1;
+}
+
+uint32_t uart_ring_rx_dropped(void) {
+    return 0;
+}
+
+unsigned uart_ring_write_nonblock(const uint8_t *buf, unsigned len) {
+    unsigned n;
+
+    for (n = 0; n < len; n++) {
+        uart_write(buf[n]);
+    }
+    return len;
+}
+
+unsigned uart_ring_tx_pending(void) {
+    return 0;
+}
+
+#endif
+
+uint8_t uart_ring_getc(void) {
+    int c;
+
+    while ((c = uart_ring_getc_nonblock()) < 0) {
+        // Wait
+    }
+    return c;
+}
+
+void uart_ring_write(const uint8_t *buf, unsigned len) {
+    unsigned n;
+
+    while (len) {
+        n = uart_ring_write_nonblock(buf, len);
+        buf += n;
+        len -= n;
+    }
+}
+
+void uart_ring_flush(void) {
+    while (uart_ring_tx_pending()) {
+        // Wait
+    }
+}
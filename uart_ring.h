@@ -0,0 +1,38 @@
+#ifndef __UART_RING_H
+#define __UART_RING_H
+
+#include <stdint.h>
+
+// Interrupt-driven UART buffers
+//
+// libbase only keeps 128 received bytes, so input is dropped while a long
+// command (benchmark, a batch of frames) keeps the CPU busy. uart_ring_init()
+// attaches its own UART handler in front of libbase's: received bytes go to
+// a larger ring, transmitted data is queued without blocking and drained
+// from the interrupt, and libbase keeps serving printf output.
+//
+// Without interrupts (or with UART_POLLING) the same calls poll the UART.
+
+// Power-of-two sizes, both buffers live in main_ram (main_ram.h)
+#ifndef UART_RING_RX_SIZE
+#define UART_RING_RX_SIZE 2048
+#endif
+#ifndef UART_RING_TX_SIZE
+#define UART_RING_TX_SIZE 1024
+#endif
+
+void uart_ring_init(void);
+
+// Receive: number of buffered bytes, non-blocking and blocking reads
+unsigned uart_ring_rx_available(void);
+int uart_ring_getc_nonblock(void);  // -1 when empty
+uint8_t uart_ring_getc(void);
+uint32_t uart_ring_rx_dropped(void);
+
+// Transmit: queue as much as fits and return the byte count, or block until all is queued
+unsigned uart_ring_write_nonblock(const uint8_t *buf, unsigned len);
+void uart_ring_write(const uint8_t *buf, unsigned len);
+unsigned uart_ring_tx_pending(void);
+void uart_ring_flush(void);
+
+#endif // __UART_RING_H